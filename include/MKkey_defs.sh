@@ -65,6 +65,7 @@ fi
 # add keys that we generate automatically:
 cat >>$data <<EOF
 key_resize	kr1	str	R1	KEY_RESIZE	+	NCURSES_SIGWINCH 	Terminal resize event
+key_paste	kpst	str	R2	KEY_PASTE	+	-	Bracketed paste received
 EOF
 
 THIS=./`basename "$0"`
@@ -94,6 +94,27 @@ extern "C" {
 
 #define IS_TIC_MAGIC(p)	(LOW_MSB(p) == MAGIC || LOW_MSB(p) == MAGIC2)
 
+/*
+** An indexed database is a single file holding a minimal perfect hash of the
+** names and aliases of its entries, followed by the compiled entries.  It is
+** recognized by the suffix of its pathname.  The header is INDEX_HEADER
+** 32-bit numbers, stored least-significant byte first like the numbers in the
+** tables which follow it:
+**
+**	magic, version, keys, buckets, names, names-size, data, data-size
+**
+** The tables are the seed for each bucket, and for each key the offsets of
+** its (null-terminated) name and compiled entry, and the size of the entry.
+** Those offsets are relative to the "names" and "data" offsets in the header.
+*/
+#define INDEX_SUFFIX	".idx"
+#define INDEX_MAGIC	0x69746e63	/* "ncti" */
+#define INDEX_VERSION	1
+#define INDEX_HEADER	8
+#define INDEX_SLOT	3	/* 32-bit numbers for each key */
+
+#define LOW_QUAD(p)	(BYTE(p,0) + 256U*(BYTE(p,1) + 256U*(BYTE(p,2) + 256U*BYTE(p,3))))
+
 #define quick_prefix(s) (!strncmp((s), "b64:", (size_t)4) || !strncmp((s), "hex:", (size_t)4))
 
 /*
@@ -270,6 +291,7 @@ extern NCURSES_EXPORT(unsigned) _nc_pathlast (const char *);
 extern NCURSES_EXPORT(bool) _nc_is_abs_path (const char *);
 extern NCURSES_EXPORT(bool) _nc_is_dir_path (const char *);
 extern NCURSES_EXPORT(bool) _nc_is_file_path (const char *);
+extern NCURSES_EXPORT(bool) _nc_is_index_path (const char *);
 extern NCURSES_EXPORT(char *) _nc_basename (char *);
 extern NCURSES_EXPORT(char *) _nc_rootname (char *);
 
@@ -337,6 +359,7 @@ extern NCURSES_EXPORT_VAR(const struct tinfo_fkeys) _nc_tinfo_fkeys[];
 extern NCURSES_EXPORT_VAR(int) _nc_tparm_err;
 
 extern NCURSES_EXPORT(int) _nc_tparm_analyze(TERMINAL *, const char *, char **, int *);
+extern NCURSES_EXPORT(int) _nc_tparm_compile(int);
 extern NCURSES_EXPORT(void) _nc_reset_tparm(TERMINAL *);
 
 /* lib_trace.c */
@@ -363,6 +386,12 @@ extern NCURSES_EXPORT(const char *) _nc_next_db(DBDIRS *, int *);
 extern NCURSES_EXPORT(const char *) _nc_tic_dir (const char *);
 extern NCURSES_EXPORT(void) _nc_first_db(DBDIRS *, int *);
 extern NCURSES_EXPORT(void) _nc_last_db(void);
+extern NCURSES_EXPORT(bool) _nc_lookup_db(const char *, DBDIRS *, int *);
+extern NCURSES_EXPORT(void) _nc_found_db(const char *, DBDIRS, int);
+extern NCURSES_EXPORT(void) _nc_forget_db(void);
+
+/* read_entry.c */
+extern NCURSES_EXPORT(unsigned) _nc_index_hash (unsigned, const char *);
 
 /* write_entry.c */
 extern NCURSES_EXPORT(int) _nc_tic_written (void);
@@ -0,0 +1,136 @@
+/****************************************************************************
+ * Copyright 2024 agent                                                     *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Author: agent                                                           *
+ ****************************************************************************/
+
+
+#include <curses.priv.h>
+#include <tic.h>
+
+MODULE_ID("$Id$")
+
+#if NCURSES_EXT_FUNCS
+#define PasteCap(name) NCURSES_SP_NAME(tigetstr) (NCURSES_SP_ARGx name)
+
+/*
+ * Enable or disable the terminal's bracketed-paste mode, using the "BE" and
+ * "BD" capabilities.  While it is enabled, the "PS" string which the terminal
+ * sends before pasted text is a key, KEY_PASTE, and wgetch collects the text
+ * up to the "PE" string for get_paste.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(use_bracketed_paste) (NCURSES_SP_DCLx bool flag)
+{
+    int code = ERR;
+
+    T((T_CALLED("use_bracketed_paste(%p,%d)"), (void *) SP_PARM, flag));
+    if (SP_PARM != 0 && HasTerminal(SP_PARM)) {
+	if (flag) {
+	    char *on = PasteCap("BE");
+	    char *off = PasteCap("BD");
+	    char *start = PasteCap("PS");
+	    char *end = PasteCap("PE");
+
+	    if (VALID_STRING(on)
+		&& VALID_STRING(off)
+		&& VALID_STRING(start)
+		&& VALID_STRING(end)
+		&& *end != '\0') {
+		if (SP_PARM->_paste_on == 0) {
+		    code = _nc_add_to_try(&(SP_PARM->_keytry), start, KEY_PASTE);
+		    if (code == OK) {
+			SP_PARM->_paste_on = on;
+			SP_PARM->_paste_off = off;
+			SP_PARM->_paste_end = end;
+			NCURSES_PUTP2_FLUSH("BE", on);
+		    }
+		} else {
+		    code = OK;
+		}
+	    }
+	} else {
+	    if (SP_PARM->_paste_on != 0) {
+		while (_nc_remove_key(&(SP_PARM->_keytry), KEY_PASTE)) {
+		    /* EMPTY */ ;
+		}
+		NCURSES_PUTP2_FLUSH("BD", SP_PARM->_paste_off);
+		SP_PARM->_paste_on = 0;
+		SP_PARM->_paste_off = 0;
+		SP_PARM->_paste_end = 0;
+	    }
+	    code = OK;
+	}
+    }
+    returnCode(code);
+}
+
+/*
+ * Copy the text of the last paste, returning its length in bytes.  Like
+ * snprintf, this copies no more than the given length, including a trailing
+ * null, and the result tells how large a buffer the whole text needs.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(get_paste) (NCURSES_SP_DCLx char *buffer, int length)
+{
+    int code = ERR;
+
+    T((T_CALLED("get_paste(%p,%p,%d)"), (void *) SP_PARM, buffer, length));
+    if (SP_PARM != 0 && SP_PARM->_paste_text != 0) {
+	size_t used = SP_PARM->_paste_used;
+
+	if (buffer != 0 && length > 0) {
+	    size_t limit = (size_t) length - 1;
+	    size_t copy = (used < limit) ? used : limit;
+
+	    memcpy(buffer, SP_PARM->_paste_text, copy);
+	    buffer[copy] = '\0';
+	}
+	code = (int) used;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+use_bracketed_paste(bool flag)
+{
+    return NCURSES_SP_NAME(use_bracketed_paste) (CURRENT_SCREEN, flag);
+}
+
+NCURSES_EXPORT(int)
+get_paste(char *buffer, int length)
+{
+    return NCURSES_SP_NAME(get_paste) (CURRENT_SCREEN, buffer, length);
+}
+#endif
+
+#else
+EMPTY_MODULE(_nc_empty_bracketed_paste)
+#endif /* NCURSES_EXT_FUNCS */
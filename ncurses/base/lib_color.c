@@ -509,8 +509,10 @@ _nc_change_pair(SCREEN *sp, int pair)
 		changed = TRUE;
 	    }
 	}
-	if (changed)
+	if (changed) {
 	    NCURSES_SP_NAME(_nc_make_oldhash) (NCURSES_SP_ARGx y);
+	    DAMAGED_ROWS(sp, y, y);
+	}
     }
 }
 
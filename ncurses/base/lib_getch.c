@@ -337,7 +337,7 @@ fifo_push(SCREEN *sp EVENTLIST_2nd(_nc_eventlist * evl))
 			     &buf);
 	c2 = buf;
 #else
-	n = (int) read(sp->_ifd, &c2, (size_t) 1);
+	n = _nc_read_input(sp, &c2, (size_t) 1);
 #endif
 	_nc_set_read_thread(FALSE);
 	ch = c2;
@@ -439,6 +439,90 @@ recur_wgetnstr(WINDOW *win, char *buf)
     return rc;
 }
 
+/*
+ * Limit the wait for the rest of a bracketed paste, in case the terminal
+ * never sends the string which ends it.
+ */
+#define PASTE_DELAY 1000
+
+static bool
+paste_byte(SCREEN *sp, int ch, size_t *matched)
+{
+    const char *end = sp->_paste_end;
+
+    if (sp->_paste_used + 1 >= sp->_paste_size) {
+	size_t want = (sp->_paste_size + 1) * 2;
+	char *text = typeRealloc(char, want, sp->_paste_text);
+
+	sp->_paste_text = text;
+	if (text == 0) {
+	    sp->_paste_used = 0;
+	    sp->_paste_size = 0;
+	    return FALSE;
+	}
+	sp->_paste_size = want;
+    }
+    sp->_paste_text[sp->_paste_used++] = (char) ch;
+    if (UChar(end[*matched]) == UChar(ch)) {
+	*matched += 1;
+    } else {
+	*matched = (UChar(end[0]) == UChar(ch)) ? 1 : 0;
+    }
+    return TRUE;
+}
+
+/*
+ * Having matched the terminal's "PS" string as KEY_PASTE, collect the pasted
+ * text up to its "PE" string for get_paste().  The text is taken in blocks
+ * from the input buffer, rather than as keys from the FIFO, leaving whatever
+ * follows the paste for wgetch.
+ */
+static void
+read_paste(SCREEN *sp)
+{
+    size_t length = strlen(sp->_paste_end);
+    size_t matched = 0;
+    bool ok = TRUE;
+
+    sp->_paste_used = 0;
+
+    /* any bytes already moved into the FIFO follow the "PS" string */
+    while (ok && matched < length && raw_key_in_fifo()) {
+	int ch = fifo_pull(sp);
+
+	if (ch >= 0 && ch < KEY_MIN)
+	    ok = paste_byte(sp, ch, &matched);
+    }
+
+    while (ok && matched < length) {
+	unsigned char block[INBUF_SIZE];
+	int got;
+	int n;
+
+	if (sp->_inbuf_head >= sp->_inbuf_tail
+	    && !_nc_timed_wait(sp, TW_INPUT, PASTE_DELAY, (int *) 0
+			       EVENTLIST_2nd(NULL))) {
+	    TR(TRACE_IEVENT, ("no end of paste"));
+	    break;
+	}
+	if ((got = _nc_read_input(sp, block, sizeof(block))) <= 0)
+	    break;
+	for (n = 0; ok && n < got && matched < length; ++n)
+	    ok = paste_byte(sp, block[n], &matched);
+	/* leave whatever follows the paste for wgetch */
+	sp->_inbuf_head -= (got - n);
+    }
+
+    if (matched == length)
+	sp->_paste_used -= length;
+    if (sp->_paste_text == 0
+	&& (sp->_paste_text = typeMalloc(char, 1)) != 0)
+	sp->_paste_size = 1;
+    if (sp->_paste_text != 0)
+	sp->_paste_text[sp->_paste_used] = '\0';
+    TR(TRACE_IEVENT, ("pasted %lu bytes", (unsigned long) sp->_paste_used));
+}
+
 NCURSES_EXPORT(int)
 _nc_wgetch(WINDOW *win,
 	   int *result,
@@ -561,6 +645,8 @@ _nc_wgetch(WINDOW *win,
 
 	do {
 	    ch = kgetch(sp, win->_notimeout EVENTLIST_2nd(evl));
+	    if (ch == KEY_PASTE && sp->_paste_end != 0)
+		read_paste(sp);
 	    if (ch == KEY_MOUSE) {
 		++runcount;
 		if (sp->_mouse_inline(sp))
@@ -714,16 +800,41 @@ wgetch(WINDOW *win)
 **
 */
 
+/*
+ * Return the time left to wait for the rest of a key sequence.  ESCDELAY
+ * limits the whole sequence, starting when kgetch first waits for it.  The
+ * start is kept if kgetch returns KEY_EVENT or ERR before the sequence is
+ * complete, so that the next call resumes with what remains.
+ */
+static int
+sequence_timeleft(SCREEN *sp, bool forever)
+{
+    int result = forever ? 9999999 : GetEscdelay(sp);
+
+    if (!forever) {
+	if (!sp->_seq_timing) {
+	    (void) _nc_gettime(&(sp->_seq_start), TRUE);
+	    sp->_seq_timing = TRUE;
+	} else {
+	    long elapsed = _nc_gettime(&(sp->_seq_start), FALSE);
+
+	    result = (elapsed >= result) ? 0 : (result - (int) elapsed);
+	}
+    }
+    return result;
+}
+
 static int
 kgetch(SCREEN *sp, bool forever EVENTLIST_2nd(_nc_eventlist * evl))
 {
-    TRIES *ptr;
+    KEY_TABLE *table;
+    int state = 0;
+    int code;
     int ch = 0;
-    int timeleft = forever ? 9999999 : GetEscdelay(sp);
 
     TR(TRACE_IEVENT, ("kgetch() called"));
 
-    ptr = sp->_keytry;
+    table = _nc_key_table(sp);
 
     for (;;) {
 	if (cooked_key_in_fifo() && sp->_fifo[head] >= KEY_MIN) {
@@ -751,41 +862,47 @@ kgetch(SCREEN *sp, bool forever EVENTLIST_2nd(_nc_eventlist * evl))
 	    peek = head;
 	    /* assume the key is the last in fifo */
 	    t_dec();		/* remove the key */
+	    sp->_seq_timing = FALSE;
 	    return ch;
 	}
 
 	TR(TRACE_IEVENT, ("ch: %s", _nc_tracechar(sp, (unsigned char) ch)));
-	while ((ptr != NULL) && (ptr->ch != (unsigned char) ch))
-	    ptr = ptr->sibling;
-
-	if (ptr == NULL) {
-	    TR(TRACE_IEVENT, ("ptr is null"));
+	if (table == NULL
+	    || (code = table->next[(state * table->width)
+				   + table->column[UChar(ch)]]) == 0) {
+	    TR(TRACE_IEVENT, ("no match"));
 	    break;
 	}
-	TR(TRACE_IEVENT, ("ptr=%p, ch=%d, value=%d",
-			  (void *) ptr, ptr->ch, ptr->value));
+	TR(TRACE_IEVENT, ("state=%d, ch=%d, next=%d", state, UChar(ch), code));
 
-	if (ptr->value != 0) {	/* sequence terminated */
+	if (code < 0) {		/* sequence terminated */
 	    TR(TRACE_IEVENT, ("end of sequence"));
 	    if (peek == tail) {
 		fifo_clear(sp);
 	    } else {
 		head = peek;
 	    }
-	    return (ptr->value);
+	    sp->_seq_timing = FALSE;
+	    return (-code);
 	}
 
-	ptr = ptr->child;
+	state = code;
 
-	if (!raw_key_in_fifo()) {
+	if (!raw_key_in_fifo()
+	    && sp->_inbuf_head >= sp->_inbuf_tail) {
 	    int rc;
+	    int timeleft;
 
 	    TR(TRACE_IEVENT, ("waiting for rest of sequence"));
-	    rc = check_mouse_activity(sp, timeleft EVENTLIST_2nd(evl));
+	    do {
+		/* a signal does not end the wait; resume it for what is left */
+		timeleft = sequence_timeleft(sp, forever);
+		errno = 0;
+		rc = check_mouse_activity(sp, timeleft EVENTLIST_2nd(evl));
+	    } while (rc == 0 && errno == EINTR && timeleft > 0);
 #ifdef NCURSES_WGETCH_EVENTS
 	    if (rc & TW_EVENT) {
 		TR(TRACE_IEVENT, ("interrupted by a user event"));
-		/* FIXME Should have preserved remainder timeleft for reuse... */
 		peek = head;	/* Restart interpreting later */
 		return KEY_EVENT;
 	    }
@@ -798,5 +915,6 @@ kgetch(SCREEN *sp, bool forever EVENTLIST_2nd(_nc_eventlist * evl))
     }
     ch = fifo_pull(sp);
     peek = head;
+    sp->_seq_timing = FALSE;
     return ch;
 }
@@ -1066,6 +1066,20 @@ decode_X10_bstate(SCREEN *sp, MEVENT * eventp, unsigned intro)
     return result;
 }
 
+/*
+ * Read the rest of a mouse report, using the screen's input buffer, which
+ * may already hold it.
+ */
+static int
+read_mouse_input(SCREEN *sp, void *buffer, size_t length)
+{
+#if USE_EMX_MOUSE
+    if (M_FD(sp) >= 0)
+	return (int) read(M_FD(sp), buffer, length);
+#endif
+    return _nc_read_input(sp, buffer, length);
+}
+
 /* This code requires that your xterm entry contain the kmous capability and
  * that it be set to the \E[M documented in the Xterm Control Sequences
  * reference.  This is how we arrange for mouse events to be reported via a
@@ -1107,13 +1121,8 @@ decode_xterm_X10(SCREEN *sp, MEVENT * eventp)
     for (grabbed = 0; grabbed < MAX_KBUF; grabbed += (size_t) res) {
 
 	/* For VIO mouse we add extra bit 64 to disambiguate button-up. */
-	res = (int) read(
-#if USE_EMX_MOUSE
-			    (M_FD(sp) >= 0) ? M_FD(sp) : sp->_ifd,
-#else
-			    sp->_ifd,
-#endif
-			    kbuf + grabbed, (size_t) (MAX_KBUF - (int) grabbed));
+	res = read_mouse_input(sp, kbuf + grabbed,
+			       (size_t) (MAX_KBUF - (int) grabbed));
 	if (res == -1)
 	    break;
     }
@@ -1155,13 +1164,7 @@ decode_xterm_1005(SCREEN *sp, MEVENT * eventp)
     for (grabbed = 0; grabbed < limit;) {
 	int res;
 
-	res = (int) read(
-#if USE_EMX_MOUSE
-			    (M_FD(sp) >= 0) ? M_FD(sp) : sp->_ifd,
-#else
-			    sp->_ifd,
-#endif
-			    (kbuf + grabbed), (size_t) 1);
+	res = read_mouse_input(sp, (kbuf + grabbed), (size_t) 1);
 	if (res == -1)
 	    break;
 	grabbed += (size_t) res;
@@ -1233,13 +1236,7 @@ read_SGR(SCREEN *sp, SGR_DATA * result)
     do {
 	int res;
 
-	res = (int) read(
-#if USE_EMX_MOUSE
-			    (M_FD(sp) >= 0) ? M_FD(sp) : sp->_ifd,
-#else
-			    sp->_ifd,
-#endif
-			    (kbuf + grabbed), (size_t) 1);
+	res = read_mouse_input(sp, (kbuf + grabbed), (size_t) 1);
 	if (res == -1)
 	    break;
 	if ((grabbed + MAX_KBUF) >= (int) sizeof(kbuf)) {
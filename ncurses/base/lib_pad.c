@@ -245,6 +245,9 @@ pnoutrefresh(WINDOW *win,
 		CHANGED_CELL(nline, n);
 	    }
 	}
+	if (nline->firstchar != _NOCHANGE) {
+	    DAMAGED_ROWS(sp, m, m);
+	}
 
 #if USE_SCROLL_HINTS
 	if (wide) {
@@ -263,13 +263,23 @@ wnoutrefresh(WINDOW *win)
 	    /*
 	     * Copy the changed text.
 	     */
-	    for (; src_col <= last_src; src_col++, dst_col++) {
-		if (!CharEq(oline->text[src_col], nline->text[dst_col])) {
+	    while (src_col <= last_src) {
+		if (CharEq(oline->text[src_col], nline->text[dst_col])) {
+		    int same = _nc_diff_first(oline->text + src_col,
+					      nline->text + dst_col,
+					      last_src + 1 - src_col);
+		    src_col += same;
+		    dst_col += same;
+		} else {
 		    nline->text[dst_col] = oline->text[src_col];
 		    CHANGED_CELL(nline, dst_col);
+		    src_col++;
+		    dst_col++;
 		}
 	    }
-
+	    if (nline->firstchar != _NOCHANGE) {
+		DAMAGED_ROWS(SP_PARM, dst_row, dst_row);
+	    }
 	}
 #if USE_SCROLL_HINTS
 	if (wide) {
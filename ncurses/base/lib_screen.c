@@ -980,6 +980,7 @@ NCURSES_SP_NAME(scr_restore) (NCURSES_SP_DCLx const char *file)
 #endif
 	(void) fclose(fp);
 	if (NewScreen(SP_PARM) != 0) {
+	    DAMAGED_ALL(SP_PARM);
 	    code = OK;
 	}
     }
@@ -1037,6 +1038,7 @@ NCURSES_SP_NAME(scr_init) (NCURSES_SP_DCLx const char *file)
 #endif
 	    (void) fclose(fp);
 	    if (CurScreen(SP_PARM) != 0) {
+		DAMAGED_ALL(SP_PARM);
 		code = OK;
 	    }
 	}
@@ -1066,6 +1068,7 @@ NCURSES_SP_NAME(scr_set) (NCURSES_SP_DCLx const char *file)
 	newscr = NewScreen(SP_PARM);
 #endif
 	if (NewScreen(SP_PARM) != 0) {
+	    DAMAGED_ALL(SP_PARM);
 	    code = OK;
 	}
     }
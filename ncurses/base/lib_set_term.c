@@ -152,6 +152,11 @@ delscreen(SCREEN *sp)
 	WINDOWLIST *wl;
 	bool is_current = (sp == CURRENT_SCREEN);
 
+#if NCURSES_EXT_FUNCS
+	if (sp->_screen_set != 0)
+	    remove_screen_set(sp->_screen_set, sp);
+#endif
+
 #ifdef USE_SP_RIPOFF
 	if (safe_ripoff_sp && safe_ripoff_sp != safe_ripoff_stack) {
 	    ripoff_t *rop;
@@ -195,6 +200,13 @@ delscreen(SCREEN *sp)
 	_nc_free_keytry(sp->_key_ok);
 	sp->_key_ok = 0;
 
+	FreeIfNeeded(sp->_paste_text);
+
+	if (sp->_keytable != 0) {
+	    free(sp->_keytable->next);
+	    FreeAndNull(sp->_keytable);
+	}
+
 	FreeIfNeeded(sp->_current_attr);
 
 	_nc_free_ordered_pairs(sp);
@@ -205,13 +217,18 @@ delscreen(SCREEN *sp)
 	FreeIfNeeded(sp->oldhash);
 	FreeIfNeeded(sp->newhash);
 	FreeIfNeeded(sp->hashtab);
+	FreeIfNeeded(sp->_plan_data);
 
 	FreeIfNeeded(sp->_acs_map);
 	FreeIfNeeded(sp->_screen_acs_map);
 
+	sp->out_nonblock = FALSE;	/* write anything still queued */
 	NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
 	NCURSES_SP_NAME(del_curterm) (NCURSES_SP_ARGx sp->_term);
 	FreeIfNeeded(sp->out_buffer);
+	FreeIfNeeded(sp->out_chain);
+	FreeIfNeeded(sp->_mvcur_memo);
+	FreeIfNeeded(sp->_mvcur_profile);
 	if (_nc_find_prescr() == sp) {
 	    _nc_forget_prescr();
 	}
@@ -449,6 +466,10 @@ NCURSES_SP_NAME(_nc_setupscreen) (
     SP_PRE_INIT(sp);
     SetNoPadding(sp);
 
+    /* allow user to choose the patience-diff planner for scrolling */
+    if (getenv("NCURSES_PATIENCE_SCROLL") != 0)
+	sp->_patience_scroll = TRUE;
+
 #if NCURSES_EXT_FUNCS
     sp->_default_color = FALSE;
     sp->_has_sgr_39_49 = FALSE;
@@ -680,6 +701,7 @@ NCURSES_SP_NAME(_nc_setupscreen) (
     sp->_resize = NCURSES_SP_NAME(resizeterm);
     sp->_ungetch = safe_ungetch;
 #endif
+    sp->_resume = NCURSES_SP_NAME(_nc_resume_output);
 
     NewScreen(sp)->_clear = TRUE;
     CurScreen(sp)->_clear = FALSE;
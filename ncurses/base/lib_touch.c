@@ -94,5 +94,12 @@ wtouchln(WINDOW *win, int y, int n, int changed)
 						   ? win->_maxx
 						   : _NOCHANGE);
     }
+    if (changed) {
+	SCREEN *sp = _nc_screen_of(win);
+
+	if (sp != 0 && IsScreenWindow(sp, win)) {
+	    DAMAGED_ROWS(sp, y, Min(y + n, win->_maxy + 1) - 1);
+	}
+    }
     returnCode(OK);
 }
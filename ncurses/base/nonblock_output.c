@@ -0,0 +1,87 @@
+/****************************************************************************
+ * Copyright 2024 agent                                                     *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Author: agent                                                           *
+ ****************************************************************************/
+
+#include <curses.priv.h>
+
+MODULE_ID("$Id$")
+
+#if NCURSES_EXT_FUNCS
+/*
+ * Enable or disable leaving output queued when the output descriptor is
+ * non-blocking and will not accept more data.  The application is
+ * responsible for setting O_NONBLOCK on the descriptor.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(use_nonblock_output) (NCURSES_SP_DCLx bool flag)
+{
+    int code = ERR;
+
+    T((T_CALLED("use_nonblock_output(%p,%d)"), (void *) SP_PARM, flag));
+    if (SP_PARM != 0 && SP_PARM->out_buffer != 0) {
+	SP_PARM->out_nonblock = flag;
+	if (!flag && SP_PARM->out_pending)
+	    NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
+	code = OK;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+use_nonblock_output(bool flag)
+{
+    return NCURSES_SP_NAME(use_nonblock_output) (CURRENT_SCREEN, flag);
+}
+#endif
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(resume_output) (NCURSES_SP_DCL0)
+{
+    int code = ERR;
+
+    T((T_CALLED("resume_output(%p)"), (void *) SP_PARM));
+    if (SP_PARM != 0)
+	code = NCURSES_SP_NAME(_nc_resume_output) (NCURSES_SP_ARG);
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+resume_output(void)
+{
+    return NCURSES_SP_NAME(resume_output) (CURRENT_SCREEN);
+}
+#endif
+
+#else
+EMPTY_MODULE(_nc_empty_nonblock_output)
+#endif /* NCURSES_EXT_FUNCS */
@@ -0,0 +1,445 @@
+/****************************************************************************
+ * Copyright 2024 agent                                                     *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Author: agent                                                           *
+ ****************************************************************************/
+
+/*
+ * A set of screens which an application serves from one thread, waiting for
+ * input on any of them.  The descriptors are registered when a screen is
+ * added, rather than each time the application waits, using epoll where it
+ * is available, and otherwise a poll() array which is kept with the set.
+ */
+
+#include <curses.priv.h>
+#include <fifo_defs.h>
+
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#define USE_EPOLL 1
+#else
+#define USE_EPOLL 0
+#endif
+
+#if !USE_EPOLL && !USE_FUNC_POLL && HAVE_SELECT
+# if HAVE_SYS_TIME_H
+#  include <sys/time.h>
+# endif
+# if HAVE_SYS_SELECT_H
+#  include <sys/select.h>
+# endif
+#define USE_SELECT 1
+#else
+#define USE_SELECT 0
+#endif
+
+MODULE_ID("$Id$")
+
+#if NCURSES_EXT_FUNCS
+
+typedef struct {
+    SCREEN *sp;
+    bool output;		/* waiting for the output descriptor */
+} SET_ENTRY;
+
+struct screen_set {
+    SET_ENTRY *entries;
+    int count;
+    int size;
+#if USE_EPOLL
+    int epfd;
+    struct epoll_event *events;	/* 2 for each entry */
+#elif USE_FUNC_POLL
+    struct pollfd *fds;		/* input and output for each entry */
+#endif
+};
+
+/*
+ * Input which was read ahead, or pushed back with ungetch, is ready without
+ * waiting for the descriptor.
+ */
+static bool
+has_input(SCREEN *sp)
+{
+    return (sp->_inbuf_head < sp->_inbuf_tail
+	    || cooked_key_in_fifo()
+	    || raw_key_in_fifo());
+}
+
+#if USE_EPOLL
+/*
+ * The event data tells which entry, and whether the event is for its output
+ * descriptor, when that is not the same as the input descriptor.
+ */
+#define SlotData(n, out) ((((uint64_t) (n)) << 1) | ((out) ? 1 : 0))
+#define SlotOf(data)     ((int) ((data) >> 1))
+#define SlotOut(data)    ((int) ((data) & 1))
+
+static int
+epoll_entry(SCREEN_SET *set, int n, int op)
+{
+    SET_ENTRY *entry = &(set->entries[n]);
+    SCREEN *sp = entry->sp;
+    bool shared = (sp->_ofd == sp->_ifd);
+    struct epoll_event ev;
+    int rc;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | ((shared && entry->output) ? EPOLLOUT : 0);
+    ev.data.u64 = SlotData(n, FALSE);
+    rc = epoll_ctl(set->epfd, op, sp->_ifd, &ev);
+    if (!shared && entry->output) {
+	ev.events = EPOLLOUT;
+	ev.data.u64 = SlotData(n, TRUE);
+	if (epoll_ctl(set->epfd, op, sp->_ofd, &ev) < 0)
+	    rc = -1;
+    }
+    return rc;
+}
+#endif
+
+/*
+ * Wait for the output descriptor only while use_nonblock_output has left
+ * output queued for it.
+ */
+static void
+watch_output(SCREEN_SET *set, int n, bool flag)
+{
+    SET_ENTRY *entry = &(set->entries[n]);
+    SCREEN *sp = entry->sp;
+
+    if (flag && sp->_ofd < 0)
+	flag = FALSE;
+    if (entry->output != flag) {
+#if USE_EPOLL
+	if (sp->_ofd == sp->_ifd) {
+	    entry->output = flag;
+	    (void) epoll_entry(set, n, EPOLL_CTL_MOD);
+	} else {
+	    struct epoll_event ev;
+
+	    memset(&ev, 0, sizeof(ev));
+	    ev.events = EPOLLOUT;
+	    ev.data.u64 = SlotData(n, TRUE);
+	    (void) epoll_ctl(set->epfd,
+			     flag ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
+			     sp->_ofd, &ev);
+	}
+#elif USE_FUNC_POLL
+	set->fds[2 * n + 1].fd = flag ? sp->_ofd : -1;
+#endif
+	entry->output = flag;
+    }
+}
+
+static void
+resume_screen(SCREEN *sp)
+{
+#if NCURSES_SP_FUNCS
+    NCURSES_SP_NAME(resume_output) (sp);
+#else
+    SCREEN *save = SP;
+
+    set_term(sp);
+    resume_output();
+    set_term(save);
+#endif
+}
+
+/*
+ * Report a screen whose descriptor has input, reading what is available into
+ * its input buffer, so that wgetch in nodelay mode need not wait.  If the
+ * read fails, wgetch will see that for itself.
+ */
+static int
+ready_screen(SCREEN *sp, SCREEN **ready, int found, int limit)
+{
+    if (found < limit && !has_input(sp)) {
+	(void) _nc_fill_input(sp);
+	ready[found++] = sp;
+    }
+    return found;
+}
+
+NCURSES_EXPORT(SCREEN_SET *)
+new_screen_set(void)
+{
+    SCREEN_SET *result;
+
+    T((T_CALLED("new_screen_set()")));
+    if ((result = typeCalloc(SCREEN_SET, 1)) != 0) {
+#if USE_EPOLL
+	if ((result->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+	    free(result);
+	    result = 0;
+	}
+#elif !USE_FUNC_POLL && !USE_SELECT
+	free(result);
+	result = 0;
+#endif
+    }
+    returnVoidPtr(result);
+}
+
+NCURSES_EXPORT(int)
+add_screen_set(SCREEN_SET *set, SCREEN *sp)
+{
+    int code = ERR;
+
+    T((T_CALLED("add_screen_set(%p,%p)"), (void *) set, (void *) sp));
+    if (set != 0
+	&& sp != 0
+	&& sp->_screen_set == 0
+	&& sp->_ifd >= 0) {
+	int n = set->count;
+
+	if (n >= set->size) {
+	    int want = (set->size + 4) * 2;
+	    /* keep the old arrays if they cannot be enlarged */
+	    SET_ENTRY *entries = realloc(set->entries,
+					 (size_t) want * sizeof(SET_ENTRY));
+#if USE_EPOLL
+	    struct epoll_event *extra;
+#elif USE_FUNC_POLL
+	    struct pollfd *extra;
+#endif
+
+	    if (entries == 0)
+		returnCode(ERR);
+	    set->entries = entries;
+#if USE_EPOLL
+	    extra = realloc(set->events,
+			    (size_t) (2 * want) * sizeof(struct epoll_event));
+	    if (extra == 0)
+		returnCode(ERR);
+	    set->events = extra;
+#elif USE_FUNC_POLL
+	    extra = realloc(set->fds,
+			    (size_t) (2 * want) * sizeof(struct pollfd));
+	    if (extra == 0)
+		returnCode(ERR);
+	    set->fds = extra;
+#endif
+	    set->size = want;
+	}
+	set->entries[n].sp = sp;
+	set->entries[n].output = FALSE;
+#if USE_EPOLL
+	if (epoll_entry(set, n, EPOLL_CTL_ADD) < 0)
+	    returnCode(ERR);
+#elif USE_FUNC_POLL
+	memset(&(set->fds[2 * n]), 0, 2 * sizeof(struct pollfd));
+	set->fds[2 * n].fd = sp->_ifd;
+	set->fds[2 * n].events = POLLIN;
+	set->fds[2 * n + 1].fd = -1;
+	set->fds[2 * n + 1].events = POLLOUT;
+#elif USE_SELECT
+	if (sp->_ifd >= FD_SETSIZE || sp->_ofd >= FD_SETSIZE)
+	    returnCode(ERR);
+#endif
+	set->count = n + 1;
+	sp->_screen_set = set;
+	sp->_set_slot = n;
+	code = OK;
+    }
+    returnCode(code);
+}
+
+NCURSES_EXPORT(int)
+remove_screen_set(SCREEN_SET *set, SCREEN *sp)
+{
+    int code = ERR;
+
+    T((T_CALLED("remove_screen_set(%p,%p)"), (void *) set, (void *) sp));
+    if (set != 0
+	&& sp != 0
+	&& sp->_screen_set == set) {
+	int n = sp->_set_slot;
+	int last = --(set->count);
+
+#if USE_EPOLL
+	(void) epoll_entry(set, n, EPOLL_CTL_DEL);
+#endif
+	if (n != last) {
+	    set->entries[n] = set->entries[last];
+	    set->entries[n].sp->_set_slot = n;
+#if USE_EPOLL
+	    (void) epoll_entry(set, n, EPOLL_CTL_MOD);
+#elif USE_FUNC_POLL
+	    set->fds[2 * n] = set->fds[2 * last];
+	    set->fds[2 * n + 1] = set->fds[2 * last + 1];
+#endif
+	}
+	sp->_screen_set = 0;
+	sp->_set_slot = 0;
+	code = OK;
+    }
+    returnCode(code);
+}
+
+NCURSES_EXPORT(void)
+free_screen_set(SCREEN_SET *set)
+{
+    T((T_CALLED("free_screen_set(%p)"), (void *) set));
+    if (set != 0) {
+	int n;
+
+	for (n = 0; n < set->count; ++n)
+	    set->entries[n].sp->_screen_set = 0;
+#if USE_EPOLL
+	close(set->epfd);
+	FreeIfNeeded(set->events);
+#elif USE_FUNC_POLL
+	FreeIfNeeded(set->fds);
+#endif
+	FreeIfNeeded(set->entries);
+	free(set);
+    }
+    returnVoid;
+}
+
+/*
+ * Wait up to the given number of milliseconds (forever if negative) for input
+ * on any of the screens in the set, storing up to "limit" of those which have
+ * input into "ready", and returning the number stored.  Screens with output
+ * queued by use_nonblock_output resume writing it when their descriptor is
+ * writable, without being reported.
+ */
+NCURSES_EXPORT(int)
+wait_screen_set(SCREEN_SET *set, int milliseconds, SCREEN **ready, int limit)
+{
+    int found = 0;
+    int result;
+    int n;
+
+    T((T_CALLED("wait_screen_set(%p,%d,%p,%d)"),
+       (void *) set, milliseconds, (void *) ready, limit));
+
+    if (set == 0 || ready == 0 || limit <= 0)
+	returnCode(ERR);
+
+    for (n = 0; n < set->count; ++n) {
+	SCREEN *sp = set->entries[n].sp;
+
+	watch_output(set, n, sp->out_pending);
+	if (found < limit && has_input(sp))
+	    ready[found++] = sp;
+    }
+    if (found)
+	milliseconds = 0;
+
+#if USE_EPOLL
+    /*
+     * epoll_wait rejects an empty array, which a set has until the first
+     * screen is added.  There is nothing to report then, but still wait.
+     */
+    if (set->size == 0) {
+	struct epoll_event none;
+
+	result = epoll_wait(set->epfd, &none, 1, milliseconds);
+    } else {
+	result = epoll_wait(set->epfd, set->events, 2 * set->size, milliseconds);
+    }
+    for (n = 0; n < result; ++n) {
+	uint64_t data = set->events[n].data.u64;
+	unsigned events = set->events[n].events;
+	SCREEN *sp = set->entries[SlotOf(data)].sp;
+
+	if (SlotOut(data)) {
+	    if (sp->out_pending)
+		resume_screen(sp);
+	} else {
+	    if ((events & EPOLLOUT) && sp->out_pending)
+		resume_screen(sp);
+	    if (events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+		found = ready_screen(sp, ready, found, limit);
+	}
+    }
+#elif USE_FUNC_POLL
+    result = poll(set->fds, (size_t) (2 * set->count), milliseconds);
+    for (n = 0; n < set->count && result > 0; ++n) {
+	SCREEN *sp = set->entries[n].sp;
+
+	if ((set->fds[2 * n + 1].revents & (POLLOUT | POLLERR | POLLHUP))
+	    && sp->out_pending)
+	    resume_screen(sp);
+	if (set->fds[2 * n].revents & (POLLIN | POLLERR | POLLHUP))
+	    found = ready_screen(sp, ready, found, limit);
+    }
+#elif USE_SELECT
+    {
+	fd_set in_set;
+	fd_set out_set;
+	struct timeval ntimeout;
+	int count = 0;
+
+	FD_ZERO(&in_set);
+	FD_ZERO(&out_set);
+	for (n = 0; n < set->count; ++n) {
+	    SCREEN *sp = set->entries[n].sp;
+
+	    FD_SET(sp->_ifd, &in_set);
+	    if (sp->_ifd >= count)
+		count = sp->_ifd + 1;
+	    if (set->entries[n].output) {
+		FD_SET(sp->_ofd, &out_set);
+		if (sp->_ofd >= count)
+		    count = sp->_ofd + 1;
+	    }
+	}
+	if (milliseconds >= 0) {
+	    ntimeout.tv_sec = milliseconds / 1000;
+	    ntimeout.tv_usec = (milliseconds % 1000) * 1000;
+	}
+	result = select(count, &in_set, &out_set, (fd_set *) 0,
+			(milliseconds >= 0) ? &ntimeout : 0);
+	for (n = 0; n < set->count && result > 0; ++n) {
+	    SCREEN *sp = set->entries[n].sp;
+
+	    if (set->entries[n].output
+		&& FD_ISSET(sp->_ofd, &out_set)
+		&& sp->out_pending)
+		resume_screen(sp);
+	    if (FD_ISSET(sp->_ifd, &in_set))
+		found = ready_screen(sp, ready, found, limit);
+	}
+    }
+#else
+    result = ERR;
+#endif
+
+    if (result < 0 && !found)
+	found = ERR;
+    TR(TRACE_IEVENT, ("wait_screen_set: %d ready", found));
+    returnCode(found);
+}
+
+#else
+EMPTY_MODULE(_nc_empty_screen_set)
+#endif /* NCURSES_EXT_FUNCS */
@@ -0,0 +1,75 @@
+/****************************************************************************
+ * Copyright 2024 agent                                                     *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+/****************************************************************************
+ *  Author: agent                                                           *
+ ****************************************************************************/
+
+#include <curses.priv.h>
+#include <tic.h>
+
+MODULE_ID("$Id$")
+
+#if NCURSES_EXT_FUNCS
+/*
+ * Enable or disable bracketing each frame written by doupdate() with the
+ * terminal's "Sync" (synchronized update) capability.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(use_sync_update) (NCURSES_SP_DCLx bool flag)
+{
+    int code = ERR;
+
+    T((T_CALLED("use_sync_update(%p,%d)"), (void *) SP_PARM, flag));
+    if (SP_PARM != 0 && HasTerminal(SP_PARM)) {
+	if (flag) {
+	    char *value = NCURSES_SP_NAME(tigetstr) (NCURSES_SP_ARGx "Sync");
+
+	    if (VALID_STRING(value)) {
+		SP_PARM->_sync_update = value;
+		code = OK;
+	    }
+	} else {
+	    SP_PARM->_sync_update = 0;
+	    code = OK;
+	}
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+use_sync_update(bool flag)
+{
+    return NCURSES_SP_NAME(use_sync_update) (CURRENT_SCREEN, flag);
+}
+#endif
+
+#else
+EMPTY_MODULE(_nc_empty_sync_update)
+#endif /* NCURSES_EXT_FUNCS */
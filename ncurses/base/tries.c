@@ -96,6 +96,7 @@ _nc_remove_key(TRIES ** tree, unsigned code)
     if (code == 0)
 	returnCode(FALSE);
 
+    ++_nc_keytry_changes;
     while (*tree != 0) {
 	if (_nc_remove_key(&(*tree)->child, code)) {
 	    returnCode(TRUE);
@@ -128,6 +129,8 @@ _nc_remove_string(TRIES ** tree, const char *string)
     if (!VALID_STRING(string) || *string == 0)
 	returnCode(FALSE);
 
+    ++_nc_keytry_changes;
+
     while (*tree != 0) {
 	if (UChar((*tree)->ch) == UChar(*string)) {
 	    if (string[1] != 0)
@@ -145,3 +148,81 @@ _nc_remove_string(TRIES ** tree, const char *string)
     }
     returnCode(FALSE);
 }
+
+static void
+count_keys(TRIES * tree, KEY_TABLE * table)
+{
+    for (; tree != 0; tree = tree->sibling) {
+	table->column[tree->ch] = 1;
+	if (tree->value == 0 && tree->child != 0) {
+	    table->rows += 1;
+	    count_keys(tree->child, table);
+	}
+    }
+}
+
+static void
+fill_keys(TRIES * tree, KEY_TABLE * table, int row, int *rows)
+{
+    for (; tree != 0; tree = tree->sibling) {
+	int *entry = table->next + (row * table->width) + table->column[tree->ch];
+
+	if (*entry != 0)
+	    continue;		/* kgetch() used the first match */
+	if (tree->value != 0) {
+	    *entry = -(int) tree->value;
+	} else if (tree->child != 0) {
+	    *entry = (*rows)++;
+	    fill_keys(tree->child, table, *entry, rows);
+	} else {
+	    *entry = table->rows - 1;	/* a row with no matches */
+	}
+    }
+}
+
+/*
+ * Return the screen's tree of key-sequences compiled into a table, rebuilding
+ * it if any tree has been modified since it was built.  Row zero is the start
+ * of a sequence, and the last row has no matches.
+ */
+NCURSES_EXPORT(KEY_TABLE *)
+_nc_key_table(SCREEN *sp)
+{
+    KEY_TABLE *table = sp->_keytable;
+
+    if (table == 0 || table->changes != _nc_keytry_changes) {
+	KEY_TABLE scan;
+	int n;
+
+	memset(&scan, 0, sizeof(scan));
+	scan.rows = 2;
+	count_keys(sp->_keytry, &scan);
+	for (n = 0, scan.width = 1; n < 256; ++n) {
+	    if (scan.column[n])
+		scan.column[n] = (unsigned short) scan.width++;
+	}
+
+	if (table != 0) {
+	    free(table->next);
+	    free(table);
+	    sp->_keytable = 0;
+	}
+	if ((table = typeMalloc(KEY_TABLE, 1)) != 0) {
+	    *table = scan;
+	    table->changes = _nc_keytry_changes;
+	    table->next = typeCalloc(int, (size_t) (scan.rows * scan.width));
+	    if (table->next != 0) {
+		int rows = 1;
+
+		fill_keys(sp->_keytry, table, 0, &rows);
+		sp->_keytable = table;
+		TR(TRACE_IEVENT, ("built key table with %d rows, %d columns",
+				  table->rows, table->width));
+	    } else {
+		free(table);
+		table = 0;
+	    }
+	}
+    }
+    return table;
+}
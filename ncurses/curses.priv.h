@@ -350,6 +350,20 @@ typedef TRIES {
 #undef TRIES
 } TRIES;
 
+/*
+ * The tries compiled for kgetch():  a row for each partial key-sequence and a
+ * column for each byte used in any sequence, so that each byte of input is
+ * matched by indexing.  An entry is the next row, the negated keycode of a
+ * complete sequence, or zero if there is no match.
+ */
+typedef struct {
+	unsigned long	changes;	/* _nc_keytry_changes when built    */
+	int		rows;		/* partial sequences, and no match  */
+	int		width;		/* columns in each row		    */
+	unsigned short	column[256];	/* byte to column, zero if unused   */
+	int		*next;		/* rows * width entries		    */
+} KEY_TABLE;
+
 /*
  * Common/troublesome character definitions
  */
@@ -374,6 +388,7 @@ typedef TRIES {
 #define MAXCOLUMNS    135
 #define MAXLINES      66
 #define FIFO_SIZE     MAXCOLUMNS+2  /* for nocbreak mode input */
+#define INBUF_SIZE    1024          /* bytes read at once from input */
 
 #define ACS_LEN       128
 
@@ -481,6 +496,7 @@ typedef union {
 #endif
 
 #define SIZEOF_SHORT         2
+#define SIZEOF_32BITS        4
 
 #ifdef CUR
 #undef CUR
@@ -756,9 +772,17 @@ extern NCURSES_EXPORT(void) _nc_set_read_thread(bool);
 
 #endif
 
+/*
+ * Timeouts are measured with a monotonic clock where possible, so that a
+ * change to the system time does not shorten or lengthen them.
+ */
 #if HAVE_CLOCK_GETTIME
 # define PRECISE_GETTIME 1
-# define GetClockTime(t) clock_gettime(CLOCK_REALTIME, t)
+# ifdef CLOCK_MONOTONIC
+#  define GetClockTime(t) clock_gettime(CLOCK_MONOTONIC, t)
+# else
+#  define GetClockTime(t) clock_gettime(CLOCK_REALTIME, t)
+# endif
 # define TimeType struct timespec
 # define TimeScale 1000000000L		/* 1e9 */
 # define sub_secs tv_nsec
@@ -987,6 +1011,25 @@ typedef struct {
 #define IsCbreak(sp)    (sp)->_tty_flags._cbreak
 #define IsEcho(sp)      (sp)->_tty_flags._echo
 
+/*
+ * While doupdate() is composing a frame, output which does not fit into the
+ * screen's output buffer is kept in a chain of filled buffers rather than
+ * being written piecemeal.  _nc_flush() writes the chain with writev().
+ */
+typedef struct {
+	char		*text;		/* a filled output buffer	    */
+	size_t		used;		/* number of bytes in text	    */
+} OUT_SEGMENT;
+
+/*
+ * With use_nonblock_output(), output which the terminal does not accept is
+ * left queued.  doupdate() and resume_output() report that as OUTPUT_PENDING.
+ */
+#ifndef OUTPUT_PENDING
+#define OUTPUT_PENDING 1
+#endif
+#define OutputStatus(sp) ((sp)->out_pending ? OUTPUT_PENDING : OK)
+
 /*
  * The SCREEN structure.
  */
@@ -997,6 +1040,18 @@ typedef struct screen {
 	char		*out_buffer;	/* output buffer		    */
 	size_t		out_limit;	/* output buffer size		    */
 	size_t		out_inuse;	/* output buffer current use	    */
+	OUT_SEGMENT	*out_chain;	/* filled buffers of current frame  */
+	size_t		out_chained;	/* number of segments in out_chain  */
+	size_t		out_chain_max;	/* allocated length of out_chain    */
+	bool		out_framing;	/* doupdate() is composing a frame  */
+	long		out_frame_bytes; /* bytes written since frame began */
+	long		out_frame_writes; /* write-calls since frame began  */
+	long		out_last_bytes;	/* bytes written for last frame	    */
+	long		out_last_writes; /* write-calls for last frame	    */
+	bool		out_nonblock;	/* leave unwritten output queued    */
+	bool		out_pending;	/* output is queued after EAGAIN    */
+	size_t		out_first;	/* first segment not yet written    */
+	size_t		out_skip;	/* bytes written from out_first     */
 	bool		_filtered;	/* filter() was called		    */
 	bool		_prescreen;	/* is in prescreen phase	    */
 	bool		_use_env;	/* LINES & COLS from environment?   */
@@ -1019,6 +1074,7 @@ typedef struct screen {
 
 	TRIES		*_keytry;	/* "Try" for use with keypad mode   */
 	TRIES		*_key_ok;	/* Disabled keys via keyok(,FALSE)  */
+	KEY_TABLE	*_keytable;	/* _keytry compiled for kgetch()    */
 	bool		_tried;		/* keypad mode was initialized	    */
 	bool		_keypad_on;	/* keypad mode is currently on	    */
 
@@ -1028,6 +1084,19 @@ typedef struct screen {
 			_fifotail,	/* tail of fifo queue		    */
 			_fifopeek,	/* where to peek for next char	    */
 			_fifohold;	/* set if breakout marked	    */
+	unsigned char	_inbuf[INBUF_SIZE];	/* bytes read from _ifd	    */
+	int		_inbuf_head,	/* next byte to take from _inbuf    */
+			_inbuf_tail;	/* end of the bytes in _inbuf	    */
+	char		*_paste_on;	/* "BE", if bracketed paste is used */
+	char		*_paste_off;	/* "BD", to disable it		    */
+	char		*_paste_end;	/* "PE", which ends pasted text	    */
+	char		*_paste_text;	/* text of the last paste	    */
+	size_t		_paste_used;	/* ...its length		    */
+	size_t		_paste_size;	/* ...allocated size		    */
+	struct screen_set *_screen_set;	/* set which waits for this screen */
+	int		_set_slot;	/* ...index of this screen in it    */
+	TimeType	_seq_start;	/* when kgetch began waiting for    */
+	bool		_seq_timing;	/* ...the rest of a key sequence    */
 
 	int		_endwin;	/* are we out of window mode?	    */
 	NCURSES_CH_T	*_current_attr; /* holds current attributes set	    */
@@ -1076,8 +1145,20 @@ typedef struct screen {
 	int		_ip_cost;	/* cost of (insert_padding)	    */
 	/* used in lib_mvcur.c */
 	char *		_address_cursor;
+	long		_output_rate;	/* pinned chars/second, or zero	    */
+	long		_measured_rate;	/* chars/second seen by doupdate    */
+	bool		_adaptive_costs; /* costs follow _measured_rate	    */
+	struct mvcur_memo *_mvcur_memo;	/* recently chosen moves	    */
+	struct mvcur_profile *_mvcur_profile; /* unshared cost samples    */
+	bool		_mvcur_overwrote; /* move depends on screen text    */
 	/* used in tty_update.c */
 	int		_scrolling;	/* 1 if terminal's smart enough to  */
+	char *		_sync_update;	/* "Sync" string, if enabled	    */
+	int		_damage_top;	/* newscr/curscr rows changed since */
+	int		_damage_bot;	/* ...doupdate, or _NOCHANGE	    */
+	int		_output_backlog; /* skip frames above this backlog  */
+	bool		_frame_skipped;	/* a frame was skipped for backlog  */
+	int		(*_resume)(NCURSES_SP_DCL0); /* _nc_resume_output   */
 
 	/* used in lib_color.c */
 	rgb_bits_t	_direct_color;	/* RGB overrides color-table	     */
@@ -1144,6 +1225,8 @@ typedef struct screen {
 	int		hashtab_len;
 	int		*_oldnum_list;
 	int		_oldnum_size;
+	bool		_patience_scroll;	/* NCURSES_PATIENCE_SCROLL */
+	struct _plan_data *_plan_data;	/* work arrays for patience planner */
 
 	NCURSES_SP_OUTC	_outch;		/* output handler if not putc */
 	NCURSES_OUTC	jump;
@@ -1572,6 +1655,24 @@ extern NCURSES_EXPORT_VAR(SIG_ATOMIC_T) _nc_have_sigwinch;
 		line->firstchar = (NCURSES_SIZE_T) (start); \
 	line->lastchar = (NCURSES_SIZE_T) (end)
 
+/*
+ * Record the rows of newscr or curscr which may have changed since the last
+ * doupdate, so that doupdate can return immediately if there are none.
+ */
+#define DAMAGED_ROWS(sp,top,bot) \
+	if ((sp)->_damage_top == _NOCHANGE \
+	 || (sp)->_damage_top > (top)) \
+		(sp)->_damage_top = (top); \
+	if ((sp)->_damage_bot == _NOCHANGE \
+	 || (sp)->_damage_bot < (bot)) \
+		(sp)->_damage_bot = (bot)
+
+#define DAMAGED_ALL(sp) \
+	DAMAGED_ROWS(sp, 0, screen_lines(sp) - 1)
+
+#define IsScreenWindow(sp,win) \
+	((win) == CurScreen(sp) || (win) == NewScreen(sp))
+
 #define SIZEOF(v) (sizeof(v)/sizeof(v[0]))
 
 #include <nc_alloc.h>
@@ -2140,10 +2241,17 @@ extern NCURSES_EXPORT(char *) _nc_strstr (const char *, const char *);
 /* safe_sprintf.c */
 extern NCURSES_EXPORT(char *) _nc_printf_string (const char *, va_list);
 
+/* cell_diff.c */
+extern NCURSES_EXPORT(int) _nc_diff_count (const NCURSES_CH_T *, const NCURSES_CH_T *, int);
+extern NCURSES_EXPORT(int) _nc_diff_count_char (const NCURSES_CH_T *, const NCURSES_CH_T *, int);
+extern NCURSES_EXPORT(int) _nc_diff_first (const NCURSES_CH_T *, const NCURSES_CH_T *, int);
+extern NCURSES_EXPORT(int) _nc_diff_last (const NCURSES_CH_T *, const NCURSES_CH_T *, int);
+
 /* tries.c */
 extern NCURSES_EXPORT(int) _nc_add_to_try (TRIES **, const char *, unsigned);
 extern NCURSES_EXPORT(char *) _nc_expand_try (TRIES *, unsigned, int *, size_t);
 extern NCURSES_EXPORT(int) _nc_remove_key (TRIES **, unsigned);
+extern NCURSES_EXPORT(KEY_TABLE *) _nc_key_table (SCREEN *);
 extern NCURSES_EXPORT(int) _nc_remove_string (TRIES **, const char *);
 
 /* elsewhere ... */
@@ -2157,6 +2265,7 @@ extern NCURSES_EXPORT(char *) _nc_tracemouse (SCREEN *, MEVENT const *);
 extern NCURSES_EXPORT(char *) _nc_trace_mmask_t (SCREEN *, mmask_t);
 extern NCURSES_EXPORT(int) _nc_access (const char *, int);
 extern NCURSES_EXPORT(int) _nc_baudrate (int);
+extern NCURSES_EXPORT(int) _nc_fill_input (SCREEN *);
 extern NCURSES_EXPORT(int) _nc_freewin (WINDOW *);
 extern NCURSES_EXPORT(int) _nc_getenv_num (const char *);
 extern NCURSES_EXPORT(int) _nc_keypad (SCREEN *, int);
@@ -2165,10 +2274,16 @@ extern NCURSES_EXPORT(int) _nc_outch (int);
 extern NCURSES_EXPORT(int) _nc_putchar (int);
 extern NCURSES_EXPORT(int) _nc_putp(const char *, const char *);
 extern NCURSES_EXPORT(int) _nc_putp_flush(const char *, const char *);
+extern NCURSES_EXPORT(int) _nc_read_input (SCREEN *, void *, size_t);
+extern NCURSES_EXPORT(int) _nc_read_shared_entry (const char *const, char *const, TERMTYPE2 *const);
 extern NCURSES_EXPORT(int) _nc_read_termcap_entry (const char *const, TERMTYPE2 *const);
 extern NCURSES_EXPORT(int) _nc_setup_tinfo(const char *, TERMTYPE2 *);
 extern NCURSES_EXPORT(int) _nc_setupscreen (int, int, FILE *, int, int);
 extern NCURSES_EXPORT(int) _nc_timed_wait (SCREEN *, int, int, int * EVENTLIST_2nd(_nc_eventlist *));
+extern NCURSES_EXPORT(long) _nc_gettime (TimeType *, int);
+extern NCURSES_EXPORT(size_t) _nc_unsent_output (SCREEN *);
+extern NCURSES_EXPORT(int) _nc_resume_output (void);
+extern NCURSES_EXPORT(void) _nc_mvcur_rate (SCREEN *, long, long);
 extern NCURSES_EXPORT(int) _nc_trans_string (char *, const char *);
 extern NCURSES_EXPORT(void) _nc_init_termtype (TERMTYPE2 *const);
 extern NCURSES_EXPORT(void) _nc_do_color (int, int, int, NCURSES_OUTC);
@@ -2179,6 +2294,7 @@ extern NCURSES_EXPORT(void) _nc_hash_map (void);
 extern NCURSES_EXPORT(void) _nc_init_keytry (SCREEN *);
 extern NCURSES_EXPORT(void) _nc_keep_tic_dir (const char *);
 extern NCURSES_EXPORT(void) _nc_make_oldhash (int i);
+extern NCURSES_EXPORT(void) _nc_release_shared_entry (TERMTYPE2 *const);
 extern NCURSES_EXPORT(void) _nc_reset_input (FILE *, char *);
 extern NCURSES_EXPORT(void) _nc_scroll_oldhash (int n, int top, int bot);
 extern NCURSES_EXPORT(void) _nc_scroll_optimize (void);
@@ -2187,6 +2303,7 @@ extern NCURSES_EXPORT(void) _nc_setenv_num (const char *, int);
 extern NCURSES_EXPORT(void) _nc_signal_handler (int);
 extern NCURSES_EXPORT(void) _nc_synchook (WINDOW *);
 extern NCURSES_EXPORT(void) _nc_trace_tries (TRIES *);
+extern NCURSES_EXPORT(void *) _nc_shared_profile (const TERMTYPE2 *const, size_t);
 
 #if NCURSES_EXT_NUMBERS
 extern NCURSES_EXPORT(const TERMTYPE2 *) _nc_fallback2 (const char *);
@@ -2218,6 +2335,8 @@ extern NCURSES_EXPORT(void) _nc_comp_userdefs_leaks(void);
 extern NCURSES_EXPORT(void) _nc_db_iterator_leaks(void);
 extern NCURSES_EXPORT(void) _nc_keyname_leaks(void);
 extern NCURSES_EXPORT(void) _nc_names_leaks(void);
+extern NCURSES_EXPORT(void) _nc_read_entry_leaks(void);
+extern NCURSES_EXPORT(void) _nc_read_termcap_leaks(void);
 extern NCURSES_EXPORT(void) _nc_tgetent_leak(const TERMINAL *);
 extern NCURSES_EXPORT(void) _nc_tgetent_leaks(void);
 #endif
@@ -2622,6 +2741,7 @@ extern NCURSES_EXPORT(int)      NCURSES_SP_NAME(_nc_outch)(SCREEN*, int);
 extern NCURSES_EXPORT(int)      NCURSES_SP_NAME(_nc_putchar)(SCREEN*, int);
 extern NCURSES_EXPORT(int)      NCURSES_SP_NAME(_nc_putp)(SCREEN*, const char *, const char*);
 extern NCURSES_EXPORT(int)      NCURSES_SP_NAME(_nc_putp_flush)(SCREEN*, const char *, const char *);
+extern NCURSES_EXPORT(int)      NCURSES_SP_NAME(_nc_resume_output)(SCREEN*);
 extern NCURSES_EXPORT(int)      NCURSES_SP_NAME(_nc_ripoffline)(SCREEN*, int, int (*)(WINDOW *,int));
 extern NCURSES_EXPORT(int)      NCURSES_SP_NAME(_nc_scrolln)(SCREEN*, int, int, int, int);
 extern NCURSES_EXPORT(int)      NCURSES_SP_NAME(_nc_set_tty_mode)(SCREEN*, TTY*);
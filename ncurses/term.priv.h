@@ -105,6 +105,7 @@ typedef struct {
 } STACK_FRAME;
 
 #define NUM_VARS 26
+#define NUM_PROGS 32	/* capabilities compiled per terminal */
 
 typedef struct {
 	const char *	tparam_base;
@@ -120,6 +121,7 @@ typedef struct {
 	size_t		fmt_size;
 
 	int		static_vars[NUM_VARS];
+	struct tparm_prog * programs[NUM_PROGS];
 #ifdef TRACE
 	const char *	tname;
 #endif
@@ -180,6 +182,16 @@ typedef struct {
 struct DriverTCB; /* Terminal Control Block forward declaration */
 #endif
 
+/*
+ * Terminal descriptions shared by setupterm (see read_entry.c).
+ */
+typedef struct _shared_entry SHARED_ENTRY;
+
+/*
+ * Results of searching the terminal databases (see db_iterator.c).
+ */
+typedef struct _db_lookup DB_LOOKUP;
+
 /*
  * Global data which is not specific to a screen.
  */
@@ -222,6 +234,15 @@ typedef struct {
 	int		dbd_size;	/* length of dbd_list[] */
 	time_t		dbd_time;	/* cache last updated */
 	ITERATOR_VARS	dbd_vars[dbdLAST];
+	DB_LOOKUP *	dbd_lookups;	/* where names were found, or not */
+	char *		dbd_searched;	/* dbd_list[] used for dbd_lookups */
+	long		dbd_hits;	/* lookups answered by dbd_lookups */
+	long		dbd_misses;	/* lookups which searched dbd_list[] */
+
+	SHARED_ENTRY *	shared_entries;	/* entries read by setupterm */
+
+	unsigned long	keytry_changes;	/* updates to any tree of keys */
+#define _nc_keytry_changes _nc_globals.keytry_changes
 
 #if HAVE_TSEARCH
 	void *		cached_tparm;
@@ -255,6 +276,7 @@ typedef struct {
 	pthread_mutex_t	mutex_update;
 	pthread_mutex_t	mutex_tst_tracef;
 	pthread_mutex_t	mutex_tracef;
+	pthread_mutex_t	mutex_tparm;
 	int		nested_tracef;
 	int		use_pthreads;
 #define _nc_use_pthreads	_nc_globals.use_pthreads
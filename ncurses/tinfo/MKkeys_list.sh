@@ -54,6 +54,7 @@ cat <<EOF
 KEY_BREAK
 KEY_SRESET
 KEY_RESET
+KEY_PASTE
 EOF
 test "$USE_SIGWINCH" = 1 && echo KEY_RESIZE
 
@@ -184,6 +184,19 @@ _nc_is_file_path(const char *path)
     return result;
 }
 
+/*
+ * Check if the pathname names an indexed database.  This looks only at the
+ * name, so that searching for a directory costs no more system calls.
+ */
+NCURSES_EXPORT(bool)
+_nc_is_index_path(const char *path)
+{
+    size_t have = strlen(path);
+    size_t need = sizeof(INDEX_SUFFIX) - 1;
+
+    return (bool) (have > need && !strcmp(path + have - need, INDEX_SUFFIX));
+}
+
 #if HAVE_GETEUID && HAVE_GETEGID
 #define is_posix_elevated() \
 	(getuid() != geteuid() \
@@ -275,7 +288,7 @@ _nc_safe_open3(const char *path, int flags, mode_t mode)
     result = open(path, flags, mode);
     resume_elevation();
 #else
-    if (!is_elevated() || (flags & O_RDONLY)) {
+    if (!is_elevated() || (flags & (O_WRONLY | O_RDWR)) == 0) {
 	result = open(path, flags, mode);
     }
 #endif
@@ -57,6 +57,8 @@ _nc_add_to_try(TRIES ** tree, const char *str, unsigned code)
     if (!VALID_STRING(str) || *txt == '\0' || code == 0)
 	returnCode(ERR);
 
+    ++_nc_keytry_changes;
+
     if ((*tree) != 0) {
 	ptr = savedptr = (*tree);
 
@@ -54,6 +54,21 @@ MODULE_ID("$Id: db_iterator.c,v 1.51 2024/07/27 19:22:23 tom Exp $")
 #define my_size          _nc_globals.dbd_size
 #define my_time          _nc_globals.dbd_time
 #define my_vars          _nc_globals.dbd_vars
+#define my_lookups       _nc_globals.dbd_lookups
+#define my_searched      _nc_globals.dbd_searched
+#define my_hits          _nc_globals.dbd_hits
+#define my_misses        _nc_globals.dbd_misses
+
+/*
+ * The result of searching the list of databases for a terminal description.
+ */
+struct _db_lookup {
+    struct _db_lookup *next;
+    char *name;
+    int found;			/* index in my_list[] of the database, or -1 */
+    int code;			/* result of a search which found nothing */
+    time_t checked;		/* when the search was made, or last verified */
+};
 
 static void
 add_to_blob(const char *text, size_t limit)
@@ -202,6 +217,84 @@ free_cache(void)
     FreeAndNull(my_list);
 }
 
+static void
+free_lookups(void)
+{
+    while (my_lookups != 0) {
+	DB_LOOKUP *next = my_lookups->next;
+
+	free(my_lookups->name);
+	free(my_lookups);
+	my_lookups = next;
+    }
+}
+
+/*
+ * The results of searches refer to databases by their position in my_list[].
+ * Keep them only while a rebuilt list is the same.
+ */
+static void
+check_searched(void)
+{
+    size_t need = 1;
+    char *joined;
+    int j;
+
+    for (j = 0; j < my_size; ++j)
+	need += strlen(my_list[j]) + 1;
+
+    if ((joined = malloc(need)) != 0) {
+	*joined = '\0';
+	for (j = 0; j < my_size; ++j) {
+	    _nc_STRCAT(joined, my_list[j], need);
+	    _nc_STRCAT(joined, "\n", need);
+	}
+	if (my_searched != 0 && !strcmp(joined, my_searched)) {
+	    free(joined);
+	} else {
+	    free_lookups();
+	    free(my_searched);
+	    my_searched = joined;
+	}
+    } else {
+	free_lookups();
+	FreeAndNull(my_searched);
+    }
+}
+
+/*
+ * Return the time when the place in a database where the name would be
+ * stored last changed:  the leaf directory of a directory tree, or else the
+ * directory or file holding the database.  That is the status-change time,
+ * since unpacking an archive can set modification times in the past.
+ */
+static time_t
+db_changed(const char *path, const char *name)
+{
+    struct stat sb;
+    char leaf[PATH_MAX];
+    time_t result = 0;
+
+    if (!quick_prefix(path)
+	&& strlen(path) + LEAF_LEN + 2 <= sizeof(leaf)) {
+	_nc_SPRINTF(leaf, _nc_SLIMIT(sizeof(leaf))
+		    "%s/" LEAF_FMT, path, UChar(*name));
+	if (stat(leaf, &sb) == 0
+	    || stat(path, &sb) == 0) {
+	    result = sb.st_ctime;
+	}
+#if USE_HASHED_DB
+	else if (strlen(path) + sizeof(DBM_SUFFIX) <= sizeof(leaf)) {
+	    _nc_SPRINTF(leaf, _nc_SLIMIT(sizeof(leaf))
+			"%s%s", path, DBM_SUFFIX);
+	    if (stat(leaf, &sb) == 0)
+		result = sb.st_ctime;
+	}
+#endif
+    }
+    return result;
+}
+
 static void
 update_tic_dir(const char *update)
 {
@@ -256,6 +349,124 @@ _nc_last_db(void)
     }
 }
 
+/*
+ * Check if an earlier search for the name can be reused, after _nc_first_db().
+ * If so, set the iterator to the database where the entry was found, or past
+ * the end of the list with the result of the search if it was not found.
+ *
+ * Like the list itself, the result is trusted for a second.  After that, the
+ * places which were searched are checked for changes since the search,
+ * costing a stat() for each rather than a failed open.
+ */
+NCURSES_EXPORT(bool)
+_nc_lookup_db(const char *name, DBDIRS * state, int *code)
+{
+    DB_LOOKUP **pp;
+    DB_LOOKUP *p;
+    bool result = FALSE;
+
+    for (pp = &my_lookups; (p = *pp) != 0; pp = &(p->next)) {
+	if (!strcmp(p->name, name)) {
+	    time_t now = time((time_t *) 0);
+
+	    if (p->found < my_size && now > p->checked) {
+		int last = (p->found >= 0) ? p->found : my_size;
+		int j;
+
+		for (j = 0; j < last; ++j) {
+		    if (db_changed(my_list[j], name) >= p->checked)
+			break;
+		}
+		if (j < last) {
+		    TR(TRACE_DATABASE, ("search for %s is out of date", name));
+		    *pp = p->next;
+		    free(p->name);
+		    free(p);
+		    break;
+		}
+		p->checked = now;
+	    }
+	    if (p->found < my_size) {
+		if (p->found >= 0) {
+		    *state = (DBDIRS) p->found;
+		} else {
+		    *state = (DBDIRS) my_size;
+		    *code = p->code;
+		}
+		result = TRUE;
+	    }
+	    break;
+	}
+    }
+
+    if (result) {
+	++my_hits;
+    } else {
+	++my_misses;
+    }
+    TR(TRACE_DATABASE, ("_nc_lookup_db %s: %s (%ld reused, %ld searched)",
+			name, result ? "reused" : "search", my_hits, my_misses));
+    return result;
+}
+
+/*
+ * Remember the result of searching for the name, given the iterator's state
+ * after the search.
+ */
+NCURSES_EXPORT(void)
+_nc_found_db(const char *name, DBDIRS state, int code)
+{
+    DB_LOOKUP *p;
+
+    if (my_list == 0)
+	return;
+
+    for (p = my_lookups; p != 0; p = p->next) {
+	if (!strcmp(p->name, name))
+	    break;
+    }
+    if (p == 0
+	&& (p = typeCalloc(DB_LOOKUP, 1)) != 0) {
+	if ((p->name = strdup(name)) != 0) {
+	    p->next = my_lookups;
+	    my_lookups = p;
+	} else {
+	    FreeAndNull(p);
+	}
+    }
+    if (p != 0) {
+	p->found = (code == TGETENT_YES) ? ((int) state - 1) : -1;
+	p->code = code;
+	p->checked = time((time_t *) 0);
+    }
+}
+
+/*
+ * Discard the results of searches, e.g., when writing entries.
+ */
+NCURSES_EXPORT(void)
+_nc_forget_db(void)
+{
+    free_lookups();
+}
+
+#if NCURSES_EXT_FUNCS
+/*
+ * Report the number of lookups which reused an earlier search, and the number
+ * which searched the databases.
+ */
+NCURSES_EXPORT(int)
+get_lookup_stats(long *reused, long *searched)
+{
+    T((T_CALLED("get_lookup_stats(%p,%p)"), (void *) reused, (void *) searched));
+    if (reused != 0)
+	*reused = my_hits;
+    if (searched != 0)
+	*searched = my_misses;
+    returnCode(OK);
+}
+#endif /* NCURSES_EXT_FUNCS */
+
 /*
  * This is a simple iterator which allows the caller to step through the
  * possible locations for a terminfo directory.  ncurses uses this to find
@@ -431,6 +642,7 @@ _nc_first_db(DBDIRS * state, int *offset)
 		}
 		my_size = j;
 		my_time = time((time_t *) 0);
+		check_searched();
 	    } else {
 		FreeAndNull(my_blob);
 	    }
@@ -450,6 +662,8 @@ _nc_db_iterator_leaks(void)
 	FreeAndNull(my_blob);
     if (my_list != 0)
 	FreeAndNull(my_list);
+    free_lookups();
+    FreeAndNull(my_searched);
     for (which = 0; (int) which < dbdLAST; ++which) {
 	my_vars[which].name = 0;
 	FreeIfNeeded(my_vars[which].value);
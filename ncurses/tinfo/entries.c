@@ -152,6 +152,8 @@ _nc_leaks_tinfo(void)
     _nc_get_type(0);
     _nc_first_name(0);
     _nc_db_iterator_leaks();
+    _nc_read_entry_leaks();
+    _nc_read_termcap_leaks();
     _nc_keyname_leaks();
 #if BROKEN_LINKER || USE_REENTRANT
     _nc_names_leaks();
@@ -51,6 +51,7 @@ really_free_termtype(TERMTYPE2 *ptr, bool freeStrings)
     T(("really_free_termtype(%s) %d", ptr->term_names, freeStrings));
 
     if (freeStrings) {
+	_nc_release_shared_entry(ptr);
 	FreeIfNeeded(ptr->str_table);
     }
     FreeIfNeeded(ptr->Booleans);
@@ -155,6 +155,14 @@ NCURSES_EXPORT_VAR(NCURSES_GLOBALS) _nc_globals = {
     0,				/* dbd_size */
     0,				/* dbd_time */
     { { 0, 0 } },		/* dbd_vars */
+    NULL,			/* dbd_lookups */
+    NULL,			/* dbd_searched */
+    0,				/* dbd_hits */
+    0,				/* dbd_misses */
+
+    NULL,			/* shared_entries */
+
+    0,				/* keytry_changes */
 
 #if HAVE_TSEARCH
     NULL,			/* cached_tparm */
@@ -185,6 +193,7 @@ NCURSES_EXPORT_VAR(NCURSES_GLOBALS) _nc_globals = {
     PTHREAD_MUTEX_INITIALIZER,	/* mutex_update */
     PTHREAD_MUTEX_INITIALIZER,	/* mutex_tst_tracef */
     PTHREAD_MUTEX_INITIALIZER,	/* mutex_tracef */
+    PTHREAD_MUTEX_INITIALIZER,	/* mutex_tparm */
     0,				/* nested_tracef */
     0,				/* use_pthreads */
 #if USE_PTHREADS_EINTR
@@ -252,6 +261,7 @@ NCURSES_EXPORT_VAR(NCURSES_PRESCREEN) _nc_prescreen = {
 	0,			/* fmt_size */
 
 	NUM_VARS_0s,		/* static_vars */
+	{ NULL },		/* programs */
 #ifdef TRACE
 	NULL,			/* tname */
 #endif
@@ -314,6 +324,7 @@ init_global_mutexes(void)
 	_nc_mutex_init(&_nc_globals.mutex_update);
 	_nc_mutex_init(&_nc_globals.mutex_tst_tracef);
 	_nc_mutex_init(&_nc_globals.mutex_tracef);
+	_nc_mutex_init(&_nc_globals.mutex_tparm);
     }
 }
 
@@ -183,9 +183,12 @@ NCURSES_SP_NAME(flushinp) (NCURSES_SP_DCL0)
 	else if (NC_ISATTY(SP_PARM->_ofd))
 	    flush_input(SP_PARM->_ofd);
 	if (SP_PARM) {
+	    SP_PARM->_inbuf_head = 0;
+	    SP_PARM->_inbuf_tail = 0;
 	    SP_PARM->_fifohead = -1;
 	    SP_PARM->_fifotail = 0;
 	    SP_PARM->_fifopeek = 0;
+	    SP_PARM->_seq_timing = FALSE;
 	}
 	returnCode(OK);
     }
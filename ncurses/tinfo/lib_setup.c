@@ -665,12 +665,18 @@ _nc_update_screensize(SCREEN *sp)
 /*
  * Return 1 if entry found, 0 if not found, -1 if database not accessible,
  * just like tgetent().
+ *
+ * The string tables are shared with other terminals using the same entry,
+ * unless _nc_tinfo_cmdch() may modify them.
  */
 int
 _nc_setup_tinfo(const char *const tn, TERMTYPE2 *const tp)
 {
     char filename[PATH_MAX];
-    int status = _nc_read_entry2(tn, filename, tp);
+    char *cc = getenv("CC");
+    int status = ((cc != 0 && strlen(cc) == 1)
+		  ? _nc_read_entry2(tn, filename, tp)
+		  : _nc_read_shared_entry(tn, filename, tp));
 
     /*
      * If we have an entry, force all of the cancelled strings to null
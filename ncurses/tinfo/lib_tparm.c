@@ -137,13 +137,76 @@ typedef struct {
     int num_popped;
     TPARM_ARG param[NUM_PARM];
     char *p_is_s[NUM_PARM];
+    struct tparm_prog *program;	/* compiled form, if any */
 } TPARM_DATA;
 
+/*
+ * A capability which is used repeatedly, e.g., cup or setaf, is compiled into
+ * an array of operations the first time it is seen for a terminal.  Literal
+ * text is copied as a block, printf-formats are parsed once, and the jumps for
+ * %t and %e are resolved to the operation at which the scan in the reference
+ * interpreter (tparam_internal) would resume.
+ */
+#define OP_TEXT '\0'		/* copy "value" bytes of "text" */
+#define OP_DECIMAL '\1'		/* %d without flags, done without sprintf */
+
+typedef struct {
+    char code;			/* OP_TEXT, or the character after "%" */
+    char index;			/* parameter or variable number */
+    short width;		/* maximum length for a printf-format */
+    int value;			/* constant, text length or jump target */
+    int where;			/* offset in the capability of this operation */
+    const char *text;		/* literal text, or a printf-format */
+} TPARM_OP;
+
+/*
+ * Most terminals use one of a few forms for cup, hpa, vpa, setaf and setab.
+ * Those are formatted directly rather than by executing the operations:
+ *
+ * SHAPE_LINEAR is literal text and numeric parameters printed with %d, with
+ * an optional %i before the first parameter, e.g.,
+ *	\E[%i%p1%d;%p2%dH
+ *
+ * SHAPE_LADDER prints one numeric parameter, choosing the text before it and
+ * an offset to subtract by comparing it with a series of limits, e.g.,
+ *	\E[%?%p1%{8}%<%t3%p1%d%e%p1%{16}%<%t9%p1%{8}%-%d%e38;5;%p1%d%;m
+ */
+#define SHAPE_NONE	0
+#define SHAPE_LINEAR	1
+#define SHAPE_LADDER	2
+
+#define MAX_RUNGS	4
+
+typedef struct {
+    int limit;			/* use this rung if the parameter is less */
+    int offset;			/* ...subtracting this from it */
+    const TPARM_OP *text;	/* ...after this text, if any */
+} TPARM_RUNG;
+
+typedef struct tparm_prog {
+    const char *source;		/* address of the capability string */
+    char *format;		/* copy of the capability string */
+    size_t length;		/* ...its length */
+    TPARM_DATA data;		/* result of _nc_tparm_analyze */
+    int num_ops;
+    TPARM_OP *ops;
+    int shape;			/* SHAPE_NONE, etc. */
+    int param;			/* SHAPE_LADDER: the parameter */
+    int num_rungs;		/* ...number of tests, plus the last part */
+    const TPARM_OP *prefix;	/* ...text before the conditional */
+    const TPARM_OP *suffix;	/* ...text after the conditional */
+    TPARM_RUNG rungs[MAX_RUNGS + 1];
+} TPARM_PROG;
+
+static bool use_programs = TRUE;
+
 #if HAVE_TSEARCH
 #define MyCache _nc_globals.cached_tparm
 #define MyCount _nc_globals.count_tparm
+#if NO_LEAKS
 static int which_tparm;
 static TPARM_DATA **delete_tparm;
+#endif
 #endif /* HAVE_TSEARCH */
 
 static char dummy[] = "";	/* avoid const-cast */
@@ -158,7 +221,7 @@ cmp_format(const void *p, const void *q)
 }
 #endif
 
-#if HAVE_TSEARCH
+#if HAVE_TSEARCH && NO_LEAKS
 static void
 visit_nodes(const void *nodep, VISIT which, int depth)
 {
@@ -170,11 +233,17 @@ visit_nodes(const void *nodep, VISIT which, int depth)
 }
 #endif
 
-NCURSES_EXPORT(void)
-_nc_free_tparm(TERMINAL *termp)
+/*
+ * The analysis cache is shared by all terminals, and is not discarded when
+ * one of them is freed, since other threads may be formatting for their own
+ * terminals.  It is bounded by the number of distinct capability strings, and
+ * is released only when checking for leaks.
+ */
+#if HAVE_TSEARCH && NO_LEAKS
+static void
+free_tparm_cache(void)
 {
-    TPARM_STATE *tps = get_tparm_state(termp);
-#if HAVE_TSEARCH
+    _nc_lock_global(tparm);
     if (MyCount != 0) {
 	delete_tparm = typeCalloc(TPARM_DATA *, MyCount);
 	if (delete_tparm != NULL) {
@@ -195,7 +264,24 @@ _nc_free_tparm(TERMINAL *termp)
 	MyCount = 0;
 	which_tparm = 0;
     }
+    _nc_unlock_global(tparm);
+}
 #endif
+
+NCURSES_EXPORT(void)
+_nc_free_tparm(TERMINAL *termp)
+{
+    TPARM_STATE *tps = get_tparm_state(termp);
+    int which;
+
+#if HAVE_TSEARCH && NO_LEAKS
+    if (_nc_globals.leak_checking)
+	free_tparm_cache();
+#endif
+    for (which = 0; which < NUM_PROGS; ++which) {
+	FreeAndNull(TPS(programs)[which]);
+    }
+
     FreeAndNull(TPS(out_buff));
     TPS(out_size) = 0;
     TPS(out_used) = 0;
@@ -592,6 +678,380 @@ _nc_tparm_analyze(TERMINAL *term, const char *string, char **p_is_s, int *popcou
     return number;
 }
 
+/*
+ * Scan forward from the "t" of %t for the matching %e or %;, or from the "e"
+ * of %e for the matching %;.  Return a pointer to the "e" or ";", or to the
+ * end of the string.
+ */
+static const char *
+skip_conditional(const char *cp, bool want_else)
+{
+    int level = 0;
+
+    cp++;
+    while (*cp) {
+	if (*cp == '%') {
+	    cp++;
+	    if (*cp == '?')
+		level++;
+	    else if (*cp == ';') {
+		if (level > 0)
+		    level--;
+		else
+		    break;
+	    } else if (want_else && *cp == 'e' && level == 0)
+		break;
+	}
+
+	if (*cp)
+	    cp++;
+    }
+    return cp;
+}
+
+/*
+ * Compile the capability string, following the same steps through it as the
+ * reference interpreter in tparam_internal.  Return false if a jump would land
+ * inside a block of literal text, or the string ends inside an operation; such
+ * strings are left to the reference interpreter.
+ */
+static bool
+compile_program(TPARM_PROG *prog, char *pool)
+{
+    const char *string = prog->format;
+    const char *cp = string;
+    int length = (int) prog->length;
+    int *resume = typeMalloc(int, length + 1);
+    int n, len;
+    bool ok = TRUE;
+    TPARM_OP *op;
+
+    if (resume == NULL)
+	return FALSE;
+    for (n = 0; n <= length; ++n)
+	resume[n] = -1;
+
+    prog->num_ops = 0;
+    while (ok && (cp - string) < length) {
+	int where = (int) (cp - string);
+	int i;
+
+	resume[where] = prog->num_ops;
+	op = &(prog->ops[prog->num_ops]);
+	memset(op, 0, sizeof(*op));
+	op->where = where;
+
+	if (*cp != '%') {
+	    op->code = OP_TEXT;
+	    op->text = cp;
+	    while (cp[1] != '\0' && cp[1] != '%')
+		++cp;
+	    op->value = (int) (cp - op->text) + 1;
+	    prog->num_ops++;
+	} else {
+	    cp = parse_format(cp + 1, pool, &len);
+	    op->code = *cp;
+	    switch (*cp) {
+	    default:
+	    case '?':
+	    case ';':
+		op = NULL;
+		break;
+
+	    case '%':
+		op->code = OP_TEXT;
+		op->text = cp;
+		op->value = 1;
+		break;
+
+	    case 'd':		/* FALLTHRU */
+	    case 'o':		/* FALLTHRU */
+	    case 'x':		/* FALLTHRU */
+	    case 'X':		/* FALLTHRU */
+	    case 's':
+		op->text = pool;
+		op->width = (short) len;
+		pool += strlen(pool) + 1;
+		if (!strcmp(op->text, "%d"))
+		    op->code = OP_DECIMAL;
+		break;
+
+	    case 'c':
+#ifdef EXP_XTERM_1005
+	    case 'u':
+#endif
+	    case 'l':
+	    case 'i':
+	    case '+':
+	    case '-':
+	    case '*':
+	    case '/':
+	    case 'm':
+	    case 'A':
+	    case 'O':
+	    case '&':
+	    case '|':
+	    case '^':
+	    case '=':
+	    case '<':
+	    case '>':
+	    case '!':
+	    case '~':
+		break;
+
+	    case 'p':
+		cp++;
+		i = (UChar(*cp) - '1');
+		if (i >= 0 && i < NUM_PARM) {
+		    op->index = (char) i;
+		} else {
+		    op = NULL;
+		}
+		break;
+
+	    case 'P':
+	    case 'g':
+		cp++;
+		if (isUPPER(*cp)) {
+		    op->index = (char) (UChar(*cp) - 'A');
+		} else if (isLOWER(*cp)) {
+		    op->index = (char) (UChar(*cp) - 'a' + NUM_VARS);
+		} else {
+		    op = NULL;
+		}
+		break;
+
+	    case S_QUOTE:
+		cp++;
+		if (*cp == '\0') {
+		    ok = FALSE;
+		} else {
+		    op->code = L_BRACE;
+		    op->value = UChar(*cp);
+		    cp++;
+		}
+		break;
+
+	    case L_BRACE:
+		cp++;
+		while (isdigit(UChar(*cp))) {
+		    op->value = (op->value * 10) + (UChar(*cp) - '0');
+		    cp++;
+		}
+		break;
+
+	    case 't':
+	    case 'e':
+		op->value = (int) (skip_conditional(cp, (*cp == 't')) - string);
+		if (op->value < length)
+		    op->value++;
+		break;
+	    }
+	    if (op != NULL)
+		prog->num_ops++;
+	}
+
+	if (*cp == '\0')
+	    break;
+	cp++;
+    }
+    resume[length] = prog->num_ops;
+
+    /* resolve the jumps for %t and %e */
+    for (n = 0; ok && n < prog->num_ops; ++n) {
+	op = &(prog->ops[n]);
+	if (op->code == 't' || op->code == 'e') {
+	    if ((op->value = resume[op->value]) < 0)
+		ok = FALSE;
+	}
+    }
+    free(resume);
+    return ok;
+}
+
+/*
+ * Check if the compiled capability is SHAPE_LINEAR.  The parameters must be
+ * numbers, and there must be an explicit %p, so that the termcap-compatible
+ * loading of the stack is not used.
+ */
+static bool
+linear_shape(const TPARM_PROG *prog)
+{
+    const TPARM_OP *op = prog->ops;
+    const TPARM_OP *last = op + prog->num_ops;
+    bool seen_parm = FALSE;
+
+    while (op < last) {
+	switch (op->code) {
+	case OP_TEXT:
+	    break;
+	case 'i':
+	    if (seen_parm)
+		return FALSE;
+	    break;
+	case 'p':
+	    if (op + 1 == last || op[1].code != OP_DECIMAL)
+		return FALSE;
+	    seen_parm = TRUE;
+	    ++op;
+	    break;
+	default:
+	    return FALSE;
+	}
+	++op;
+    }
+    return seen_parm;
+}
+
+/*
+ * Check if the compiled capability is SHAPE_LADDER, filling in the rungs.
+ */
+#define OpIs(n, c) ((n) < prog->num_ops && ops[n].code == (c))
+
+static bool
+ladder_shape(TPARM_PROG *prog)
+{
+    const TPARM_OP *ops = prog->ops;
+    TPARM_RUNG *rung;
+    int n = 0;
+    int tail = -1;
+
+    prog->prefix = OpIs(n, OP_TEXT) ? &ops[n++] : NULL;
+    if (!OpIs(n, 'p'))
+	return FALSE;
+    prog->param = ops[n].index;
+    prog->num_rungs = 0;
+
+    for (;;) {
+	rung = &(prog->rungs[prog->num_rungs]);
+	memset(rung, 0, sizeof(*rung));
+	if (OpIs(n, 'p')
+	    && ops[n].index == prog->param
+	    && OpIs(n + 1, L_BRACE)
+	    && OpIs(n + 2, '<')
+	    && OpIs(n + 3, 't')) {
+	    /* %p1%{8}%<%t text %p1 [%{8}%-] %d %e */
+	    int skip = ops[n + 3].value;
+
+	    if (prog->num_rungs >= MAX_RUNGS)
+		return FALSE;
+	    rung->limit = ops[n + 1].value;
+	    n += 4;
+	    rung->text = OpIs(n, OP_TEXT) ? &ops[n++] : NULL;
+	    if (!OpIs(n, 'p') || ops[n].index != prog->param)
+		return FALSE;
+	    ++n;
+	    if (OpIs(n, L_BRACE) && OpIs(n + 1, '-')) {
+		rung->offset = ops[n].value;
+		n += 2;
+	    }
+	    if (!OpIs(n, OP_DECIMAL) || !OpIs(n + 1, 'e'))
+		return FALSE;
+	    if (tail < 0)
+		tail = ops[n + 1].value;
+	    else if (tail != ops[n + 1].value)
+		return FALSE;
+	    n += 2;
+	    if (skip != n)
+		return FALSE;
+	    prog->num_rungs++;
+	} else {
+	    /* the last part: text %p1 %d */
+	    rung->limit = 0;
+	    rung->text = OpIs(n, OP_TEXT) ? &ops[n++] : NULL;
+	    if (!OpIs(n, 'p')
+		|| ops[n].index != prog->param
+		|| !OpIs(n + 1, OP_DECIMAL))
+		return FALSE;
+	    n += 2;
+	    break;
+	}
+    }
+    if (prog->num_rungs == 0 || tail != n)
+	return FALSE;
+    prog->suffix = OpIs(n, OP_TEXT) ? &ops[n++] : NULL;
+    return (n == prog->num_ops);
+}
+
+#undef OpIs
+
+static int
+find_shape(TPARM_PROG *prog, const TPARM_DATA *data)
+{
+    int result = SHAPE_NONE;
+
+    if (data->tparm_type == 0 && data->num_popped != 0) {
+	if (linear_shape(prog))
+	    result = SHAPE_LINEAR;
+	else if (ladder_shape(prog))
+	    result = SHAPE_LADDER;
+    }
+    return result;
+}
+
+/*
+ * Return the compiled form of the capability, making it if this is the first
+ * time the capability is used for this terminal.  Capabilities are identified
+ * by address, since they are normally given as members of the terminal's
+ * description, but the text is compared too, for callers which reuse a buffer.
+ */
+#define ProgSlot(string) (int) (((size_t) (string) >> 3) % NUM_PROGS)
+
+static TPARM_PROG *
+find_program(TPARM_STATE *tps, const char *string)
+{
+    TPARM_PROG *prog = TPS(programs)[ProgSlot(string)];
+
+    if (prog != NULL
+	&& (prog->source != string || strcmp(prog->format, string)))
+	prog = NULL;
+    return prog;
+}
+
+static void
+save_program(TPARM_STATE *tps, const char *string, TPARM_DATA *data)
+{
+    size_t length = strlen(string);
+    size_t need = (sizeof(TPARM_PROG)
+		   + (length + 1) * sizeof(TPARM_OP)
+		   + (length + 1)	/* copy of the string */
+		   + (length + 1) * 3);	/* printf-formats */
+    TPARM_PROG *prog = (TPARM_PROG *) calloc((size_t) 1, need);
+
+    if (prog != NULL) {
+	TPARM_PROG **slot = &(TPS(programs)[ProgSlot(string)]);
+
+	prog->ops = (TPARM_OP *) (void *) (prog + 1);
+	prog->format = (char *) (prog->ops + length + 1);
+	prog->source = string;
+	prog->length = length;
+	strcpy(prog->format, string);
+
+	if (compile_program(prog, prog->format + length + 1)) {
+	    data->program = prog;
+	    prog->shape = find_shape(prog, data);
+	} else {
+	    data->program = NULL;
+	}
+	prog->data = *data;
+
+	FreeIfNeeded(*slot);
+	*slot = prog;
+    }
+}
+
+/*
+ * For testing, compare the compiled and reference interpreters by turning off
+ * the former.  Return the previous setting.
+ */
+NCURSES_EXPORT(int)
+_nc_tparm_compile(int enable)
+{
+    int result = use_programs;
+    use_programs = (enable != 0);
+    return result;
+}
+
 /*
  * Analyze the capability string, finding the number of parameters and their
  * types.
@@ -602,24 +1062,40 @@ static int
 tparm_setup(TERMINAL *term, const char *string, TPARM_DATA *result)
 {
     TPARM_STATE *tps = get_tparm_state(term);
+    TPARM_PROG *prog;
     int rc = OK;
 
     TPS(out_used) = 0;
-    memset(result, 0, sizeof(*result));
 
     if (!VALID_STRING(string)) {
 	TR(TRACE_CALLS, ("%s: format is invalid", TPS(tname)));
+	memset(result, 0, sizeof(*result));
 	rc = ERR;
+    } else if (use_programs && (prog = find_program(tps, string)) != NULL) {
+	*result = prog->data;
+	if (prog->length + 2 > TPS(fmt_size)) {
+	    TPS(fmt_size) += prog->length + 2;
+	    TPS(fmt_buff) = typeRealloc(char, TPS(fmt_size), TPS(fmt_buff));
+	    if (TPS(fmt_buff) == 0)
+		return ERR;
+	}
     } else {
 #if HAVE_TSEARCH
 	TPARM_DATA *fs;
 	void *ft;
+#endif
 
+	memset(result, 0, sizeof(*result));
+#if HAVE_TSEARCH
 	result->format = string;
+	_nc_lock_global(tparm);
 	if ((ft = tfind(result, &MyCache, cmp_format)) != 0) {
-	    size_t len2;
 	    fs = *(TPARM_DATA **) ft;
 	    *result = *fs;
+	}
+	_nc_unlock_global(tparm);
+	if (ft != 0) {
+	    size_t len2;
 	    if ((len2 = strlen(string)) + 2 > TPS(fmt_size)) {
 		TPS(fmt_size) += len2 + 2;
 		TPS(fmt_buff) = typeRealloc(char, TPS(fmt_size), TPS(fmt_buff));
@@ -642,6 +1118,9 @@ tparm_setup(TERMINAL *term, const char *string, TPARM_DATA *result)
 		rc = ERR;
 	    } else {
 		int n;
+#if HAVE_TSEARCH
+		char *format;
+#endif
 
 		if (result->num_parsed > NUM_PARM)
 		    result->num_parsed = NUM_PARM;
@@ -656,12 +1135,26 @@ tparm_setup(TERMINAL *term, const char *string, TPARM_DATA *result)
 #if HAVE_TSEARCH
 		if ((fs = typeCalloc(TPARM_DATA, 1)) != 0) {
 		    *fs = *result;
-		    if ((fs->format = strdup(string)) != 0) {
-			if (tsearch(fs, &MyCache, cmp_format) != 0) {
+		    if ((format = strdup(string)) != 0) {
+			/*
+			 * Another thread may have added the same string while
+			 * this one was analyzing it.  Keep the first.
+			 */
+			bool added = FALSE;
+
+			fs->format = format;
+			_nc_lock_global(tparm);
+			ft = tsearch(fs, &MyCache, cmp_format);
+			if (ft != 0 && *(TPARM_DATA **) ft == fs) {
 			    ++MyCount;
-			} else {
+			    added = TRUE;
+			}
+			_nc_unlock_global(tparm);
+			if (!added) {
+			    free(format);
 			    free(fs);
-			    rc = ERR;
+			    if (ft == 0)
+				rc = ERR;
 			}
 		    } else {
 			free(fs);
@@ -673,6 +1166,8 @@ tparm_setup(TERMINAL *term, const char *string, TPARM_DATA *result)
 #endif
 	    }
 	}
+	if (rc == OK && use_programs)
+	    save_program(tps, string, result);
     }
 
     return rc;
@@ -767,12 +1262,331 @@ tparm_trace_call(TPARM_STATE *tps, const char *string, TPARM_DATA *data)
 	    memset(name##_vars, 0, sizeof(name##_vars)); \
 	}
 
+static char *
+tparm_result(TPARM_STATE *tps)
+{
+    get_space(tps, (size_t) 1);
+    TPS(out_buff)[TPS(out_used)] = '\0';
+
+    if (TPS(stack_ptr) && !_nc_tparm_err) {
+	DEBUG(2, ("tparm: stack has %d item%s on return",
+		  TPS(stack_ptr),
+		  TPS(stack_ptr) == 1 ? "" : "s"));
+	_nc_tparm_err++;
+    }
+
+    T((T_RETURN("%s"), _nc_visbuf(TPS(out_buff))));
+    return (TPS(out_buff));
+}
+
+static void
+put_text(TPARM_STATE *tps, const TPARM_OP *op)
+{
+    get_space(tps, (size_t) op->value);
+    memcpy(TPS(out_buff) + TPS(out_used), op->text, (size_t) op->value);
+    TPS(out_used) += (size_t) op->value;
+}
+
+/* the same as save_number() with "%d" */
+static void
+put_decimal(TPARM_STATE *tps, int number)
+{
+    char digits[20];
+    unsigned value = ((number < 0)
+		      ? (0U - (unsigned) number)
+		      : (unsigned) number);
+    int n = 0;
+
+    do {
+	digits[n++] = (char) ('0' + (value % 10));
+	value /= 10;
+    } while (value != 0);
+    if (number < 0)
+	digits[n++] = '-';
+    get_space(tps, (size_t) n);
+    while (n > 0)
+	TPS(out_buff)[TPS(out_used)++] = digits[--n];
+}
+
+static char *
+linear_format(TPARM_STATE *tps, const TPARM_PROG *prog, TPARM_DATA *data)
+{
+    const TPARM_OP *op = prog->ops;
+    const TPARM_OP *last = op + prog->num_ops;
+    bool incremented_two = FALSE;
+
+    for (; op < last; ++op) {
+	switch (op->code) {
+	case OP_TEXT:
+	    put_text(tps, op);
+	    break;
+	case 'i':
+	    if (!incremented_two) {
+		incremented_two = TRUE;
+		data->param[0]++;
+		data->param[1]++;
+	    }
+	    break;
+	case 'p':
+	    put_decimal(tps, (int) data->param[(int) op->index]);
+	    ++op;		/* skip the OP_DECIMAL */
+	    break;
+	}
+    }
+    return tparm_result(tps);
+}
+
+static char *
+ladder_format(TPARM_STATE *tps, const TPARM_PROG *prog, TPARM_DATA *data)
+{
+    int value = (int) data->param[prog->param];
+    const TPARM_RUNG *rung = prog->rungs;
+    const TPARM_RUNG *last = rung + prog->num_rungs;
+
+    while (rung < last && value >= rung->limit)
+	++rung;
+    if (prog->prefix)
+	put_text(tps, prog->prefix);
+    if (rung->text)
+	put_text(tps, rung->text);
+    put_decimal(tps, value - rung->offset);
+    if (prog->suffix)
+	put_text(tps, prog->suffix);
+    return tparm_result(tps);
+}
+
+/*
+ * Execute a compiled capability.  This must give the same result as the
+ * corresponding case in tparam_internal.
+ */
+static char *
+tparam_compiled(TPARM_STATE *tps,
+		const char *string,
+		TPARM_DATA *data,
+		bool termcap_hack)
+{
+    const TPARM_PROG *prog = data->program;
+    const TPARM_OP *op = prog->ops;
+    const TPARM_OP *last = op + prog->num_ops;
+    bool incremented_two = FALSE;
+    bool dynamic_used = FALSE;
+    int dynamic_vars[NUM_VARS];
+    int x, y;
+    const char *s;
+
+    switch (prog->shape) {
+    case SHAPE_LINEAR:
+	return linear_format(tps, prog, data);
+    case SHAPE_LADDER:
+	return ladder_format(tps, prog, data);
+    }
+
+    while (op < last) {
+	TPS(tparam_base) = string + op->where;
+	switch (op->code) {
+	case OP_TEXT:
+	    put_text(tps, op);
+	    break;
+
+	case OP_DECIMAL:
+	    x = npop(tps);
+	    put_decimal(tps, x);
+	    break;
+
+	case 'd':		/* FALLTHRU */
+	case 'o':		/* FALLTHRU */
+	case 'x':		/* FALLTHRU */
+	case 'X':		/* FALLTHRU */
+	    x = npop(tps);
+	    save_number(tps, op->text, x, op->width);
+	    break;
+
+	case 'c':
+	    x = npop(tps);
+	    save_char(tps, x);
+	    break;
+
+#ifdef EXP_XTERM_1005
+	case 'u':
+	    {
+		unsigned char target[10];
+		unsigned source = (unsigned) npop(tps);
+		int rc = _nc_conv_to_utf8(target, source, (unsigned)
+					  sizeof(target));
+		int n;
+		for (n = 0; n < rc; ++n) {
+		    save_char(tps, target[n]);
+		}
+	    }
+	    break;
+#endif
+	case 'l':
+	    s = spop(tps);
+	    npush(tps, (int) strlen(s));
+	    break;
+
+	case 's':
+	    s = spop(tps);
+	    save_text(tps, op->text, s, op->width);
+	    break;
+
+	case 'p':
+	    if (data->p_is_s[(int) op->index]) {
+		spush(tps, data->p_is_s[(int) op->index]);
+	    } else {
+		npush(tps, (int) data->param[(int) op->index]);
+	    }
+	    break;
+
+	case 'P':
+	    if (op->index < NUM_VARS) {
+		TPS(static_vars)[(int) op->index] = npop(tps);
+	    } else {
+		init_vars(dynamic);
+		dynamic_vars[op->index - NUM_VARS] = npop(tps);
+	    }
+	    break;
+
+	case 'g':
+	    if (op->index < NUM_VARS) {
+		npush(tps, TPS(static_vars)[(int) op->index]);
+	    } else {
+		init_vars(dynamic);
+		npush(tps, dynamic_vars[op->index - NUM_VARS]);
+	    }
+	    break;
+
+	case L_BRACE:
+	    npush(tps, op->value);
+	    break;
+
+	case '+':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x + y);
+	    break;
+
+	case '-':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x - y);
+	    break;
+
+	case '*':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x * y);
+	    break;
+
+	case '/':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, y ? (x / y) : 0);
+	    break;
+
+	case 'm':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, y ? (x % y) : 0);
+	    break;
+
+	case 'A':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, y && x);
+	    break;
+
+	case 'O':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, y || x);
+	    break;
+
+	case '&':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x & y);
+	    break;
+
+	case '|':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x | y);
+	    break;
+
+	case '^':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x ^ y);
+	    break;
+
+	case '=':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x == y);
+	    break;
+
+	case '<':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x < y);
+	    break;
+
+	case '>':
+	    y = npop(tps);
+	    x = npop(tps);
+	    npush(tps, x > y);
+	    break;
+
+	case '!':
+	    x = npop(tps);
+	    npush(tps, !x);
+	    break;
+
+	case '~':
+	    x = npop(tps);
+	    npush(tps, ~x);
+	    break;
+
+	case 'i':
+	    if (!incremented_two) {
+		incremented_two = TRUE;
+		if (data->p_is_s[0] == 0) {
+		    data->param[0]++;
+		    if (termcap_hack)
+			TPS(stack)[0].data.num = (int) data->param[0];
+		}
+		if (data->p_is_s[1] == 0) {
+		    data->param[1]++;
+		    if (termcap_hack)
+			TPS(stack)[1].data.num = (int) data->param[1];
+		}
+	    }
+	    break;
+
+	case 't':
+	    x = npop(tps);
+	    if (!x) {
+		op = prog->ops + op->value;
+		continue;
+	    }
+	    break;
+
+	case 'e':
+	    op = prog->ops + op->value;
+	    continue;
+	}
+	++op;
+    }
+
+    return tparm_result(tps);
+}
+
 static NCURSES_INLINE char *
 tparam_internal(TPARM_STATE *tps, const char *string, TPARM_DATA *data)
 {
     int number;
     int len;
-    int level;
     int x, y;
     int i;
     const char *s;
@@ -803,6 +1617,9 @@ tparam_internal(TPARM_STATE *tps, const char *string, TPARM_DATA *data)
 	return NULL;
     }
 
+    if (data->program != NULL)
+	return tparam_compiled(tps, string, data, termcap_hack);
+
     while ((cp - string) < (int) len2) {
 	if (*cp != '%') {
 	    save_char(tps, UChar(*cp));
@@ -1023,48 +1840,13 @@ tparam_internal(TPARM_STATE *tps, const char *string, TPARM_DATA *data)
 		x = npop(tps);
 		if (!x) {
 		    /* scan forward for %e or %; at level zero */
-		    cp++;
-		    level = 0;
-		    while (*cp) {
-			if (*cp == '%') {
-			    cp++;
-			    if (*cp == '?')
-				level++;
-			    else if (*cp == ';') {
-				if (level > 0)
-				    level--;
-				else
-				    break;
-			    } else if (*cp == 'e' && level == 0)
-				break;
-			}
-
-			if (*cp)
-			    cp++;
-		    }
+		    cp = skip_conditional(cp, TRUE);
 		}
 		break;
 
 	    case 'e':
 		/* scan forward for a %; at level zero */
-		cp++;
-		level = 0;
-		while (*cp) {
-		    if (*cp == '%') {
-			cp++;
-			if (*cp == '?')
-			    level++;
-			else if (*cp == ';') {
-			    if (level > 0)
-				level--;
-			    else
-				break;
-			}
-		    }
-
-		    if (*cp)
-			cp++;
-		}
+		cp = skip_conditional(cp, FALSE);
 		break;
 
 	    case ';':
@@ -1079,18 +1861,7 @@ tparam_internal(TPARM_STATE *tps, const char *string, TPARM_DATA *data)
 	cp++;
     }				/* endwhile (*cp) */
 
-    get_space(tps, (size_t) 1);
-    TPS(out_buff)[TPS(out_used)] = '\0';
-
-    if (TPS(stack_ptr) && !_nc_tparm_err) {
-	DEBUG(2, ("tparm: stack has %d item%s on return",
-		  TPS(stack_ptr),
-		  TPS(stack_ptr) == 1 ? "" : "s"));
-	_nc_tparm_err++;
-    }
-
-    T((T_RETURN("%s"), _nc_visbuf(TPS(out_buff))));
-    return (TPS(out_buff));
+    return tparm_result(tps);
 }
 
 #ifdef CUR
@@ -1303,6 +2074,62 @@ tiscan_s(int *num_expected, int *tparm_type, const char *string)
     return result;
 }
 
+/*
+ * Format the capability and send it with tputs, using the library's output
+ * function, which copies the formatted text into the screen's output buffer
+ * between padding specifications.
+ */
+static int
+put_tiparm(NCURSES_SP_DCLx int affcnt, const char *string, va_list ap)
+{
+    TERMINAL *term = TerminalOf(SP_PARM);
+    TPARM_STATE *tps = get_tparm_state(term);
+    TPARM_DATA myData;
+    char *result = NULL;
+
+    _nc_tparm_err = 0;
+#ifdef TRACE
+    tps->tname = "tiparm_put";
+#endif /* TRACE */
+
+    if (tparm_setup(term, string, &myData) == OK && ValidCap(TRUE)) {
+	tparm_copy_valist(&myData, FALSE, ap);
+	result = tparam_internal(tps, string, &myData);
+    }
+    if (result == NULL)
+	return ERR;
+    return NCURSES_SP_NAME(tputs) (NCURSES_SP_ARGx
+				   result,
+				   affcnt,
+				   NCURSES_SP_NAME(_nc_outch));
+}
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(tiparm_put) (NCURSES_SP_DCLx int affcnt, const char *string, ...)
+{
+    va_list ap;
+    int code;
+
+    va_start(ap, string);
+    code = put_tiparm(NCURSES_SP_ARGx affcnt, string, ap);
+    va_end(ap);
+    return code;
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+tiparm_put(int affcnt, const char *string, ...)
+{
+    va_list ap;
+    int code;
+
+    va_start(ap, string);
+    code = put_tiparm(CURRENT_SCREEN, affcnt, string, ap);
+    va_end(ap);
+    return code;
+}
+#endif
+
 /*
  * The internal-use flavor ensures that parameters are numbers, not strings.
  * In addition to ensuring that they are numbers, it ensures that the parameter
@@ -52,6 +52,51 @@
 #include <termcap.h>		/* ospeed */
 #include <tic.h>
 
+#if !USE_FUNC_POLL && HAVE_SELECT
+# if HAVE_SYS_TIME_H && HAVE_SYS_TIME_SELECT
+#  include <sys/time.h>
+# endif
+# if HAVE_SYS_SELECT_H
+#  include <sys/select.h>
+# endif
+#endif
+
+#if HAVE_SYS_UIO_H && HAVE_WRITEV
+#include <sys/uio.h>
+#define USE_WRITEV 1
+#else
+#define USE_WRITEV 0
+#endif
+
+#if USE_WRITEV
+#if defined(IOV_MAX) && (IOV_MAX < 64)
+#define MAX_SEGMENTS IOV_MAX
+#else
+#define MAX_SEGMENTS 64
+#endif
+typedef struct iovec OUT_VECTOR;
+#define VecText(v) (v).iov_base
+#define VecUsed(v) (v).iov_len
+#define WriteVector(fd, vec, count) writev(fd, vec, count)
+#else
+#define MAX_SEGMENTS 1
+typedef OUT_SEGMENT OUT_VECTOR;
+#define VecText(v) (v).text
+#define VecUsed(v) (v).used
+#define WriteVector(fd, vec, count) write(fd, (vec)[0].text, (vec)[0].used)
+#endif
+
+/*
+ * The chain of filled buffers is followed by the buffer which is being filled.
+ */
+#define SegCount(sp)  ((sp)->out_chained + 1)
+#define SegText(sp,n) (((n) < (sp)->out_chained) \
+		       ? (sp)->out_chain[n].text \
+		       : (sp)->out_buffer)
+#define SegUsed(sp,n) (((n) < (sp)->out_chained) \
+		       ? (sp)->out_chain[n].used \
+		       : (sp)->out_inuse)
+
 MODULE_ID("$Id: lib_tputs.c,v 1.111 2023/09/16 16:05:15 tom Exp $")
 
 NCURSES_EXPORT_VAR(char) PC = 0;              /* used by termcap library */
@@ -120,36 +165,189 @@ delay_output(int ms)
 }
 #endif
 
-NCURSES_EXPORT(void)
-NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_DCL0)
+/*
+ * Move the filled output buffer to the frame's chain, and allocate a new one
+ * to continue with.  If we cannot, the caller falls back to flushing.
+ */
+static bool
+chain_out_buffer(SCREEN *sp)
 {
-    T((T_CALLED("_nc_flush(%p)"), (void *) SP_PARM));
-    if (SP_PARM != 0 && SP_PARM->_ofd >= 0) {
-	TR(TRACE_CHARPUT, ("ofd:%d inuse:%lu buffer:%p",
-			   SP_PARM->_ofd,
-			   (unsigned long) SP_PARM->out_inuse,
-			   SP_PARM->out_buffer));
-	if (SP_PARM->out_inuse) {
-	    char *buf = SP_PARM->out_buffer;
-	    size_t amount = SP_PARM->out_inuse;
+    char *fresh;
 
-	    TR(TRACE_CHARPUT, ("flushing %ld/%ld bytes",
-			       (unsigned long) amount, _nc_outchars));
-	    while (amount) {
-		ssize_t res = write(SP_PARM->_ofd, buf, amount);
-		if (res > 0) {
-		    /* if the write was incomplete, try again */
-		    amount -= (size_t) res;
-		    buf += res;
-		} else if (errno == EAGAIN) {
-		    continue;
-		} else if (errno == EINTR) {
-		    continue;
-		} else {
-		    break;	/* an error we can not recover from */
-		}
+    if (sp->out_chained >= sp->out_chain_max) {
+	size_t want = (sp->out_chain_max + 4) * 2;
+	OUT_SEGMENT *chain = realloc(sp->out_chain, want * sizeof(OUT_SEGMENT));
+
+	if (chain == 0)
+	    return FALSE;
+	sp->out_chain = chain;
+	sp->out_chain_max = want;
+    }
+    if ((fresh = malloc(sp->out_limit)) == 0)
+	return FALSE;
+
+    sp->out_chain[sp->out_chained].text = sp->out_buffer;
+    sp->out_chain[sp->out_chained].used = sp->out_inuse;
+    sp->out_chained++;
+    sp->out_buffer = fresh;
+    sp->out_inuse = 0;
+    return TRUE;
+}
+
+/*
+ * Return the number of bytes written to the screen's output buffers which
+ * have not yet been sent.
+ */
+NCURSES_EXPORT(size_t)
+_nc_unsent_output(SCREEN *sp)
+{
+    size_t result = 0;
+    size_t n;
+
+    for (n = sp->out_first; n < SegCount(sp); ++n)
+	result += SegUsed(sp, n);
+    return result - sp->out_skip;
+}
+
+/*
+ * Wait until the output descriptor will accept more data, rather than
+ * retrying the write in a loop.
+ */
+static void
+wait_writable(int fd)
+{
+#if USE_FUNC_POLL
+    struct pollfd fds;
+
+    fds.fd = fd;
+    fds.events = POLLOUT;
+    fds.revents = 0;
+    (void) poll(&fds, (size_t) 1, -1);
+#elif HAVE_SELECT
+    fd_set set;
+
+    FD_ZERO(&set);
+    FD_SET(fd, &set);
+    (void) select(fd + 1, NULL, &set, NULL, NULL);
+#else
+    (void) fd;
+#endif
+}
+
+/*
+ * Discard the chained buffers which have been written completely, so that a
+ * queue left by a partial write holds only the unsent part.
+ */
+static void
+trim_segments(SCREEN *sp)
+{
+    size_t done = Min(sp->out_first, sp->out_chained);
+
+    if (done != 0) {
+	size_t n;
+
+	for (n = 0; n < done; ++n)
+	    free(sp->out_chain[n].text);
+	sp->out_chained -= done;
+	memmove(sp->out_chain,
+		sp->out_chain + done,
+		sp->out_chained * sizeof(OUT_SEGMENT));
+	sp->out_first -= done;
+    }
+}
+
+/*
+ * Write the chained buffers and the current buffer, using as few calls as
+ * possible.  Partial writes resume from the segment and offset reached.
+ *
+ * If the descriptor is non-blocking and "defer" is set, stop when it will
+ * not accept more data, leaving the rest queued for a later call.
+ */
+static void
+write_segments(SCREEN *sp, bool defer)
+{
+    sp->out_pending = FALSE;
+    for (;;) {
+	OUT_VECTOR vec[MAX_SEGMENTS];
+	int count = 0;
+	ssize_t res;
+
+	while (sp->out_first < SegCount(sp)
+	       && SegUsed(sp, sp->out_first) == sp->out_skip) {
+	    sp->out_skip = 0;
+	    ++(sp->out_first);
+	}
+	if (sp->out_first >= SegCount(sp))
+	    break;
+
+	while (count < MAX_SEGMENTS
+	       && sp->out_first + (size_t) count < SegCount(sp)) {
+	    size_t n = sp->out_first + (size_t) count;
+	    size_t offset = count ? 0 : sp->out_skip;
+
+	    VecText(vec[count]) = SegText(sp, n) + offset;
+	    VecUsed(vec[count]) = SegUsed(sp, n) - offset;
+	    ++count;
+	}
+
+	res = WriteVector(sp->_ofd, vec, count);
+	if (res > 0) {
+	    size_t amount = (size_t) res;
+
+	    sp->out_frame_bytes += (long) res;
+	    sp->out_frame_writes++;
+	    while (sp->out_first < SegCount(sp)
+		   && amount >= SegUsed(sp, sp->out_first) - sp->out_skip) {
+		amount -= SegUsed(sp, sp->out_first) - sp->out_skip;
+		sp->out_skip = 0;
+		++(sp->out_first);
 	    }
-	} else if (SP_PARM->out_buffer == 0) {
+	    sp->out_skip += amount;
+	} else if (errno == EAGAIN) {
+	    if (defer) {
+		TR(TRACE_CHARPUT, ("output pending at segment %lu+%lu",
+				   (unsigned long) sp->out_first,
+				   (unsigned long) sp->out_skip));
+		trim_segments(sp);
+		sp->out_pending = TRUE;
+		return;
+	    }
+	    wait_writable(sp->_ofd);
+	} else if (errno == EINTR) {
+	    continue;
+	} else {
+	    break;		/* an error we can not recover from */
+	}
+    }
+
+    while (sp->out_chained != 0) {
+	free(sp->out_chain[--(sp->out_chained)].text);
+    }
+    sp->out_first = 0;
+    sp->out_skip = 0;
+}
+
+/*
+ * Output may be left queued only while the screen is active; endwin() and
+ * delscreen() must leave the terminal complete.
+ */
+#define MayDefer(sp) ((sp)->out_nonblock && (sp)->_endwin != ewSuspend)
+
+static void
+flush_output(SCREEN *sp, bool defer)
+{
+    if (sp != 0 && sp->_ofd >= 0) {
+	TR(TRACE_CHARPUT, ("ofd:%d inuse:%lu chained:%lu buffer:%p",
+			   sp->_ofd,
+			   (unsigned long) sp->out_inuse,
+			   (unsigned long) sp->out_chained,
+			   sp->out_buffer));
+	if (sp->out_inuse || sp->out_chained) {
+	    TR(TRACE_CHARPUT, ("flushing %ld/%ld bytes",
+			       (unsigned long) _nc_unsent_output(sp),
+			       _nc_outchars));
+	    write_segments(sp, defer);
+	} else if (sp->out_buffer == 0) {
 	    TR(TRACE_CHARPUT, ("flushing stdout"));
 	    fflush(stdout);
 	}
@@ -157,8 +355,15 @@ NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_DCL0)
 	TR(TRACE_CHARPUT, ("flushing stdout"));
 	fflush(stdout);
     }
-    if (SP_PARM != 0)
-	SP_PARM->out_inuse = 0;
+    if (sp != 0 && !sp->out_pending)
+	sp->out_inuse = 0;
+}
+
+NCURSES_EXPORT(void)
+NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_DCL0)
+{
+    T((T_CALLED("_nc_flush(%p)"), (void *) SP_PARM));
+    flush_output(SP_PARM, SP_PARM != 0 && MayDefer(SP_PARM));
     returnVoid;
 }
 
@@ -170,6 +375,33 @@ _nc_flush(void)
 }
 #endif
 
+/*
+ * Append a block of text to the output buffer, giving the same result as
+ * calling _nc_outch() for each character.
+ */
+static void
+out_block(SCREEN *sp, const char *text, size_t length)
+{
+    COUNT_OUTCHARS((long) length);
+
+    while (length != 0) {
+	size_t room;
+
+	if (sp->out_inuse + 1 >= sp->out_limit
+	    && !((sp->out_framing || sp->out_pending)
+		 && chain_out_buffer(sp)))
+	    flush_output(sp, FALSE);
+	if (sp->out_inuse + 1 >= sp->out_limit)
+	    room = 1;		/* as _nc_outch() would */
+	else
+	    room = Min(length, sp->out_limit - 1 - sp->out_inuse);
+	memcpy(sp->out_buffer + sp->out_inuse, text, room);
+	sp->out_inuse += room;
+	text += room;
+	length -= room;
+    }
+}
+
 NCURSES_EXPORT(int)
 NCURSES_SP_NAME(_nc_outch) (NCURSES_SP_DCLx int ch)
 {
@@ -180,8 +412,10 @@ NCURSES_SP_NAME(_nc_outch) (NCURSES_SP_DCLx int ch)
     if (HasTInfoTerminal(SP_PARM)
 	&& SP_PARM != 0) {
 	if (SP_PARM->out_buffer != 0) {
-	    if (SP_PARM->out_inuse + 1 >= SP_PARM->out_limit)
-		NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
+	    if (SP_PARM->out_inuse + 1 >= SP_PARM->out_limit
+		&& !((SP_PARM->out_framing || SP_PARM->out_pending)
+		     && chain_out_buffer(SP_PARM)))
+		flush_output(SP_PARM, FALSE);
 	    SP_PARM->out_buffer[SP_PARM->out_inuse++] = (char) ch;
 	} else {
 	    char tmp = (char) ch;
@@ -282,6 +516,7 @@ NCURSES_SP_NAME(tputs) (NCURSES_SP_DCLx
     NCURSES_SP_OUTC my_outch = GetOutCh();
     bool always_delay = FALSE;
     bool normal_delay = FALSE;
+    bool by_block = FALSE;
     int number;
 #if BSD_TPUTS
     int trailpad;
@@ -362,11 +597,28 @@ NCURSES_SP_NAME(tputs) (NCURSES_SP_DCLx
     }
 #endif /* BSD_TPUTS */
 
+    /*
+     * The library's own output function can be given the text between
+     * padding specifications as a block.
+     */
+    if (outc == NCURSES_SP_NAME(_nc_outch)
+	&& SP_PARM != 0
+	&& HasTInfoTerminal(SP_PARM)
+	&& SP_PARM->out_buffer != 0)
+	by_block = TRUE;
+
     SetOutCh(outc);		/* redirect delay_output() */
     while (*string) {
-	if (*string != '$')
-	    (*outc) (NCURSES_SP_ARGx *string);
-	else {
+	if (*string != '$') {
+	    if (by_block) {
+		size_t length = strcspn(string, "$");
+
+		out_block(SP_PARM, string, length);
+		string += length - 1;
+	    } else {
+		(*outc) (NCURSES_SP_ARGx *string);
+	    }
+	} else {
 	    string++;
 	    if (*string != '<') {
 		(*outc) (NCURSES_SP_ARGx '$');
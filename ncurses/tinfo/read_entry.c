@@ -46,8 +46,6 @@ MODULE_ID("$Id: read_entry.c,v 1.173 2024/07/27 23:07:02 tom Exp $")
 
 #define MyNumber(n) (short) LOW_MSB(n)
 
-#define SIZEOF_32BITS 4
-
 #if NCURSES_USE_DATABASE
 #if NCURSES_EXT_NUMBERS
 static size_t
@@ -143,9 +141,16 @@ convert_strings(char *buf, char **Strings, int count, int size,
 		char *table, bool always)
 {
     int i;
-    char *p;
+    char *last = table + size;
     bool success = TRUE;
 
+    /*
+     * A string is terminated if it begins before the last NUL in the table.
+     * Finding that once avoids scanning each string for its NUL.
+     */
+    while (last > table && last[-1] != '\0')
+	--last;
+
     for (i = 0; i < count; i++) {
 	if (IS_NEG1(buf + 2 * i)) {
 	    Strings[i] = ABSENT_STRING;
@@ -169,13 +174,10 @@ convert_strings(char *buf, char **Strings, int count, int size,
 
 	/* make sure all strings are NUL terminated */
 	if (VALID_STRING(Strings[i])) {
-	    for (p = Strings[i]; p < table + size; p++)
-		if (*p == '\0')
-		    break;
 	    /* if there is no NUL, ignore the string */
-	    if (p >= table + size) {
+	    if (Strings[i] >= last) {
 		Strings[i] = ABSENT_STRING;
-	    } else if (p == Strings[i] && always) {
+	    } else if (*Strings[i] == '\0' && always) {
 		TR(TRACE_DATABASE,
 		   ("found empty but required Strings[%d]", i));
 		success = FALSE;
@@ -570,6 +572,35 @@ _nc_read_termtype(TERMTYPE2 *ptr, char *buffer, int limit)
     returnDB(TGETENT_YES);
 }
 
+/*
+ * Read the file into the buffer, up to its size.  Compiled entries are small;
+ * knowing the size lets a single read() suffice, where stdio would make a
+ * second call to find the end of the file.
+ */
+static int
+read_file_data(int fd, char *buffer, size_t length)
+{
+    struct stat sb;
+    size_t want = length;
+    size_t have = 0;
+
+    if (fstat(fd, &sb) == 0
+	&& S_ISREG(sb.st_mode)
+	&& (size_t) sb.st_size < want)
+	want = (size_t) sb.st_size;
+
+    while (have < want) {
+	ssize_t got = read(fd, buffer + have, want - have);
+
+	if (got < 0 && errno == EINTR)
+	    continue;
+	if (got <= 0)
+	    break;
+	have += (size_t) got;
+    }
+    return (int) have;
+}
+
 /*
  *	int
  *	_nc_read_file_entry(filename, ptr)
@@ -582,18 +613,18 @@ NCURSES_EXPORT(int)
 _nc_read_file_entry(const char *const filename, TERMTYPE2 *ptr)
 /* return 1 if read, 0 if not found or garbled */
 {
-    FILE *fp = 0;
+    int fd = -1;
     int code;
 
     if (_nc_access(filename, R_OK) < 0
-	|| (fp = safe_fopen(filename, BIN_R)) == 0) {
+	|| (fd = safe_open2(filename, O_RDONLY | O_BINARY)) < 0) {
 	TR(TRACE_DATABASE, ("cannot open terminfo %s (errno=%d)", filename, errno));
 	code = TGETENT_NO;
     } else {
 	int limit;
 	char buffer[MAX_ENTRY_SIZE + 1];
 
-	limit = (int) fread(buffer, sizeof(char), sizeof(buffer), fp);
+	limit = read_file_data(fd, buffer, sizeof(buffer));
 	if (limit > 0) {
 	    const char *old_source = _nc_get_source();
 
@@ -607,12 +638,115 @@ _nc_read_file_entry(const char *const filename, TERMTYPE2 *ptr)
 	} else {
 	    code = TGETENT_NO;
 	}
-	fclose(fp);
+	close(fd);
     }
 
     return (code);
 }
 
+/*
+ * Hash a name for the indexed database.  This is FNV-1a, with the seed mixed
+ * into its starting value and a final avalanche step, so that each seed gives
+ * an unrelated hash function.
+ */
+NCURSES_EXPORT(unsigned)
+_nc_index_hash(unsigned seed, const char *name)
+{
+    unsigned long value = (2166136261UL ^ (seed * 2654435769UL)) & 0xffffffffUL;
+
+    while (*name != '\0') {
+	value = ((value ^ UChar(*name++)) * 16777619UL) & 0xffffffffUL;
+    }
+    value ^= (value >> 16);
+    value = (value * 0x85ebca6bUL) & 0xffffffffUL;
+    value ^= (value >> 13);
+    value = (value * 0xc2b2ae35UL) & 0xffffffffUL;
+    value ^= (value >> 16);
+    return (unsigned) value;
+}
+
+/*
+ * Read part of an indexed database.
+ */
+static bool
+read_index_data(int fd, size_t offset, char *buffer, size_t length)
+{
+    ssize_t got;
+
+#if HAVE_PREAD
+    got = pread(fd, buffer, length, (off_t) offset);
+#else
+    got = ((lseek(fd, (off_t) offset, SEEK_SET) < 0)
+	   ? -1
+	   : read(fd, buffer, length));
+#endif
+    return (got >= 0 && (size_t) got == length);
+}
+
+/*
+ * Read the entry for the given name from an indexed database.  The perfect
+ * hash gives the only slot where the name can be, so the lookup reads just
+ * the header, a seed, a slot and the compiled entry, however many entries the
+ * file holds.  The entry is checked against the name, rather than reading the
+ * key as well.
+ */
+static int
+read_index_entry(const char *const path, const char *name, TERMTYPE2 *const tp)
+{
+#define IndexWord(p,n) (size_t) LOW_QUAD((p) + (n) * SIZEOF_32BITS)
+    int code = TGETENT_NO;
+    int fd = -1;
+
+    if (_nc_access(path, R_OK) < 0
+	|| (fd = safe_open2(path, O_RDONLY | O_BINARY)) < 0) {
+	TR(TRACE_DATABASE, ("cannot open index %s (errno=%d)", path, errno));
+    } else {
+	char header[INDEX_HEADER * SIZEOF_32BITS];
+	char slot[INDEX_SLOT * SIZEOF_32BITS];
+	char buffer[MAX_ENTRY_SIZE + 1];
+
+	if (read_index_data(fd, (size_t) 0, header, sizeof(header))
+	    && IndexWord(header, 0) == INDEX_MAGIC
+	    && IndexWord(header, 1) == INDEX_VERSION
+	    && IndexWord(header, 2) != 0
+	    && IndexWord(header, 3) != 0) {
+	    size_t keys = IndexWord(header, 2);
+	    size_t buckets = IndexWord(header, 3);
+	    size_t data = IndexWord(header, 6);
+	    size_t bucket = _nc_index_hash(0, name) % buckets;
+
+	    if (read_index_data(fd,
+				(INDEX_HEADER + bucket) * SIZEOF_32BITS,
+				slot, (size_t) SIZEOF_32BITS)) {
+		unsigned seed = (unsigned) IndexWord(slot, 0);
+		size_t which = _nc_index_hash(seed, name) % keys;
+		size_t base = INDEX_HEADER + buckets + (INDEX_SLOT * which);
+
+		if (read_index_data(fd, base * SIZEOF_32BITS, slot, sizeof(slot))) {
+		    size_t offset = IndexWord(slot, 1);
+		    size_t size = IndexWord(slot, 2);
+
+		    if (size <= MAX_ENTRY_SIZE
+			&& read_index_data(fd, data + offset, buffer, size)) {
+			TR(TRACE_DATABASE, ("read index %s for %s", path, name));
+			code = _nc_read_termtype(tp, buffer, (int) size);
+			if (code == TGETENT_YES
+			    && !_nc_name_match(tp->term_names, name, "|")) {
+			    code = TGETENT_NO;
+			}
+			if (code == TGETENT_NO) {
+			    _nc_free_termtype2(tp);
+			}
+		    }
+		}
+	    }
+	}
+	close(fd);
+    }
+    return code;
+#undef IndexWord
+}
+
 #if USE_HASHED_DB
 /*
  * Return if if we can build the filename of a ".db" file.
@@ -764,6 +898,141 @@ decode_quickdump(char *target, const char *source)
     return result;
 }
 
+/*
+ * Entries which setupterm reads from the filesystem are kept, so that other
+ * terminals using the same file share its string tables rather than reading
+ * and parsing it again.  Each terminal has its own copy of the arrays, since
+ * _nc_setup_tinfo() modifies those.  An entry is used only while its file's
+ * device, inode, size and modification time match those seen when it was
+ * read.
+ */
+struct _shared_entry {
+    struct _shared_entry *next;
+    char *filename;
+    char *name;			/* the entry's name, in an indexed database */
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    int refs;			/* number of terminals using the tables */
+    bool stale;			/* file changed since the entry was read */
+    void *profile;		/* cost samples kept by lib_mvcur.c */
+    TERMTYPE2 data;
+};
+
+#define SharedEntries _nc_globals.shared_entries
+
+static void
+free_shared_entry(SHARED_ENTRY * target)
+{
+    SHARED_ENTRY **pp;
+
+    for (pp = &SharedEntries; *pp != 0; pp = &((*pp)->next)) {
+	if (*pp == target) {
+	    *pp = target->next;
+	    break;
+	}
+    }
+    _nc_free_termtype2(&(target->data));
+    free(target->filename);
+    FreeIfNeeded(target->name);
+    FreeIfNeeded(target->profile);
+    free(target);
+}
+
+static void
+share_entry(TERMTYPE2 *dst, const TERMTYPE2 *src)
+{
+    *dst = *src;
+
+    TYPE_MALLOC(NCURSES_SBOOL, NUM_BOOLEANS(dst), dst->Booleans);
+    TYPE_MALLOC(NCURSES_INT2, NUM_NUMBERS(dst), dst->Numbers);
+    TYPE_MALLOC(char *, NUM_STRINGS(dst), dst->Strings);
+
+    memcpy(dst->Booleans, src->Booleans,
+	   NUM_BOOLEANS(dst) * sizeof(dst->Booleans[0]));
+    memcpy(dst->Numbers, src->Numbers,
+	   NUM_NUMBERS(dst) * sizeof(dst->Numbers[0]));
+    memcpy(dst->Strings, src->Strings,
+	   NUM_STRINGS(dst) * sizeof(dst->Strings[0]));
+#if NCURSES_XNAMES
+    if (NUM_EXT_NAMES(dst) != 0) {
+	TYPE_MALLOC(char *, NUM_EXT_NAMES(dst), dst->ext_Names);
+	memcpy(dst->ext_Names, src->ext_Names,
+	       NUM_EXT_NAMES(dst) * sizeof(dst->ext_Names[0]));
+    }
+#endif
+}
+
+static int
+read_shared_entry(const char *const filename,
+		  const char *name,
+		  TERMTYPE2 *const tp)
+{
+    struct stat sb;
+    SHARED_ENTRY *p;
+    int code = TGETENT_NO;
+
+    if (_nc_access(filename, R_OK) < 0
+	|| stat(filename, &sb) < 0) {
+	TR(TRACE_DATABASE, ("cannot open terminfo %s (errno=%d)", filename, errno));
+	return code;
+    }
+
+    _nc_lock_global(curses);
+    for (p = SharedEntries; p != 0; p = p->next) {
+	if (!p->stale
+	    && !strcmp(p->filename, filename)
+	    && ((name == NULL)
+		? (p->name == NULL)
+		: (p->name != NULL && !strcmp(p->name, name)))) {
+	    if (p->dev == sb.st_dev
+		&& p->ino == sb.st_ino
+		&& p->size == sb.st_size
+		&& p->mtime == sb.st_mtime)
+		break;
+	    TR(TRACE_DATABASE, ("shared terminfo %s has changed", filename));
+	    p->stale = TRUE;
+	    if (p->refs == 0)
+		free_shared_entry(p);
+	    p = 0;
+	    break;
+	}
+    }
+
+    if (p == 0
+	&& (p = typeCalloc(SHARED_ENTRY, 1)) != 0) {
+	if ((p->filename = strdup(filename)) != 0
+	    && (name == NULL || (p->name = strdup(name)) != 0)
+	    && ((name == NULL)
+		? _nc_read_file_entry(filename, &(p->data))
+		: read_index_entry(filename, name, &(p->data))) == TGETENT_YES) {
+	    p->dev = sb.st_dev;
+	    p->ino = sb.st_ino;
+	    p->size = sb.st_size;
+	    p->mtime = sb.st_mtime;
+	    p->next = SharedEntries;
+	    SharedEntries = p;
+	} else {
+	    FreeIfNeeded(p->filename);
+	    FreeIfNeeded(p->name);
+	    free(p);
+	    p = 0;
+	}
+    } else if (p != 0) {
+	TR(TRACE_DATABASE, ("sharing terminfo %s (%d)", filename, p->refs));
+    }
+
+    if (p != 0) {
+	share_entry(tp, &(p->data));
+	p->refs++;
+	code = TGETENT_YES;
+    }
+    _nc_unlock_global(curses);
+
+    return code;
+}
+
 /*
  * Build a terminfo pathname and try to read the data.  Returns TGETENT_YES on
  * success, TGETENT_NO on failure.
@@ -773,7 +1042,8 @@ _nc_read_tic_entry(char *filename,
 		   unsigned limit,
 		   const char *const path,
 		   const char *name,
-		   TERMTYPE2 *const tp)
+		   TERMTYPE2 *const tp,
+		   bool shared)
 {
     int code = TGETENT_NO;
 #if USE_HASHED_DB
@@ -794,6 +1064,12 @@ _nc_read_tic_entry(char *filename,
 	TR(TRACE_DATABASE, ("loaded quick-dump for %s", name));
 	/* shorten name shown by infocmp */
 	_nc_STRCPY(filename, "$TERMINFO", limit);
+    } else if (_nc_is_index_path(path)) {
+	code = (shared
+		? read_shared_entry(path, name, tp)
+		: read_index_entry(path, name, tp));
+	_nc_STRNCPY(filename, path, limit - 1);
+	filename[limit - 1] = '\0';
     } else
 #if USE_HASHED_DB
 	if (make_db_filename(filename, limit, path)
@@ -858,7 +1134,9 @@ _nc_read_tic_entry(char *filename,
     } else			/* may be either filesystem or flat file */
 #endif
     if (make_dir_filename(filename, limit, path, name)) {
-	code = _nc_read_file_entry(filename, tp);
+	code = (shared
+		? read_shared_entry(filename, NULL, tp)
+		: _nc_read_file_entry(filename, tp));
     }
 #if NCURSES_USE_TERMCAP
     if (code != TGETENT_YES) {
@@ -871,18 +1149,97 @@ _nc_read_tic_entry(char *filename,
 }
 #endif /* NCURSES_USE_DATABASE */
 
+/*
+ * If the string tables of the given entry are shared, release them rather than
+ * letting the caller free them.  The shared entry is discarded when no longer
+ * used if its file has changed.
+ */
+NCURSES_EXPORT(void)
+_nc_release_shared_entry(TERMTYPE2 *const tp)
+{
+#if NCURSES_USE_DATABASE
+    SHARED_ENTRY *p;
+
+    if (tp->str_table == 0)
+	return;
+
+    _nc_lock_global(curses);
+    for (p = SharedEntries; p != 0; p = p->next) {
+	if (p->data.str_table == tp->str_table) {
+	    tp->str_table = 0;
+#if NCURSES_XNAMES
+	    tp->ext_str_table = 0;
+#endif
+	    if (--(p->refs) <= 0 && p->stale)
+		free_shared_entry(p);
+	    break;
+	}
+    }
+    _nc_unlock_global(curses);
+#else
+    (void) tp;
+#endif
+}
+
+/*
+ * Return storage of the given size which is kept with the shared entry used by
+ * a terminal, allocating it on the first call.  The cursor-movement code uses
+ * this to measure the entry's capabilities once rather than for each screen.
+ * Returns null if the entry is not shared.
+ */
+NCURSES_EXPORT(void *)
+_nc_shared_profile(const TERMTYPE2 *const tp, size_t size)
+{
+    void *result = 0;
+#if NCURSES_USE_DATABASE
+    SHARED_ENTRY *p;
+
+    if (tp->str_table == 0)
+	return result;
+
+    _nc_lock_global(curses);
+    for (p = SharedEntries; p != 0; p = p->next) {
+	if (p->data.str_table == tp->str_table) {
+	    if (p->profile == 0)
+		p->profile = calloc((size_t) 1, size);
+	    result = p->profile;
+	    break;
+	}
+    }
+    _nc_unlock_global(curses);
+#else
+    (void) tp;
+    (void) size;
+#endif
+    return result;
+}
+
+#if NO_LEAKS
+NCURSES_EXPORT(void)
+_nc_read_entry_leaks(void)
+{
+#if NCURSES_USE_DATABASE
+    while (SharedEntries != 0)
+	free_shared_entry(SharedEntries);
+#endif
+}
+#endif
+
 /*
  * Find and read the compiled entry for a given terminal type, if it exists.
  * We take pains here to make sure no combination of environment variables and
  * terminal type name can be used to overrun the file buffer.
  */
-NCURSES_EXPORT(int)
-_nc_read_entry2(const char *const name, char *const filename, TERMTYPE2 *const tp)
+static int
+read_entry(const char *const name,
+	   char *const filename,
+	   TERMTYPE2 *const tp,
+	   bool shared)
 {
     int code = TGETENT_NO;
 
     if (name == 0)
-	return _nc_read_entry2("", filename, tp);
+	return read_entry("", filename, tp, shared);
 
     _nc_SPRINTF(filename, _nc_SLIMIT(PATH_MAX)
 		"%.*s", PATH_MAX - 1, name);
@@ -899,26 +1256,62 @@ _nc_read_entry2(const char *const name, char *const filename, TERMTYPE2 *const t
 	int offset;
 	const char *path;
 
+	bool search = TRUE;
+
 	_nc_first_db(&state, &offset);
 	code = TGETENT_ERR;
-	while ((path = _nc_next_db(&state, &offset)) != 0) {
-	    code = _nc_read_tic_entry(filename, PATH_MAX, path, name, tp);
-	    if (code == TGETENT_YES) {
-		_nc_last_db();
-		break;
+	if (_nc_lookup_db(name, &state, &code)) {
+	    search = FALSE;
+	    if ((path = _nc_next_db(&state, &offset)) != 0) {
+		code = _nc_read_tic_entry(filename, PATH_MAX, path, name, tp, shared);
+		if (code != TGETENT_YES) {
+		    _nc_first_db(&state, &offset);
+		    code = TGETENT_ERR;
+		    search = TRUE;
+		}
 	    }
 	}
+	if (search) {
+	    while ((path = _nc_next_db(&state, &offset)) != 0) {
+		code = _nc_read_tic_entry(filename, PATH_MAX, path, name, tp, shared);
+		if (code == TGETENT_YES)
+		    break;
+	    }
+	    _nc_found_db(name, state, code);
+	}
+	if (code == TGETENT_YES)
+	    _nc_last_db();
 #elif NCURSES_USE_TERMCAP
+	(void) shared;
 	if (code != TGETENT_YES) {
 	    code = _nc_read_termcap_entry(name, tp);
 	    _nc_SPRINTF(filename, _nc_SLIMIT(PATH_MAX)
 			"%.*s", PATH_MAX - 1, _nc_get_source());
 	}
+#else
+	(void) shared;
 #endif
     }
     return code;
 }
 
+NCURSES_EXPORT(int)
+_nc_read_entry2(const char *const name, char *const filename, TERMTYPE2 *const tp)
+{
+    return read_entry(name, filename, tp, FALSE);
+}
+
+/*
+ * Like _nc_read_entry2(), but an entry read from the filesystem shares its
+ * string tables with other terminals using the same file.  Release those with
+ * _nc_release_shared_entry(), which _nc_free_termtype2() does.
+ */
+NCURSES_EXPORT(int)
+_nc_read_shared_entry(const char *const name, char *const filename, TERMTYPE2 *const tp)
+{
+    return read_entry(name, filename, tp, TRUE);
+}
+
 #if NCURSES_EXT_NUMBERS
 NCURSES_EXPORT(int)
 _nc_read_entry(const char *const name, char *const filename, TERMTYPE *const tp)
@@ -956,8 +956,370 @@ add_tc(char *termpaths[], char *path, int count)
 #define ADD_TC(path, count) filecount = add_tc(termpaths, path, count)
 #endif /* !USE_GETCAP */
 
-NCURSES_EXPORT(int)
-_nc_read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
+#if !USE_GETCAP
+/*
+ * Parsing every entry of the termcap files for each lookup is slow if they are
+ * large, and checking the resulting list for name collisions is quadratic.
+ * Instead, each file is read once and its records are indexed by name.  A
+ * lookup parses only the record for the name, and those which it names with
+ * tc= (or use=), found through the index.  An index is rebuilt if its file's
+ * device, inode, size or modification time changes.
+ *
+ * The converted entries are kept, and copied for later lookups of the same
+ * names while the files are unchanged.  An entry which uses a compiled
+ * terminfo entry is not kept, since that could change independently.
+ */
+typedef struct {
+    size_t offset;		/* start of the record in the file */
+    size_t length;
+    int line;			/* line number of its first line */
+    unsigned stamp;		/* lookup which last parsed the record */
+} TC_RECORD;
+
+typedef struct {
+    const char *name;		/* points into the file's text */
+    size_t length;
+    int record;
+} TC_NAME;
+
+typedef struct _tc_file {
+    struct _tc_file *next;
+    char *path;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    char *text;			/* the file's contents */
+    TC_RECORD *records;
+    int nrecords;
+    TC_NAME *names;		/* hash table of the records' names */
+    unsigned mask;		/* size of the table, less one */
+} TC_FILE;
+
+typedef struct _tc_entry {
+    struct _tc_entry *next;
+    char *name;
+    TERMTYPE2 data;
+} TC_ENTRY;
+
+static TC_FILE *tc_files;
+static TC_ENTRY *tc_entries;
+static char *tc_paths;		/* the files searched for tc_entries */
+static unsigned tc_stamp;
+
+static unsigned
+tc_hash(const char *name, size_t length)
+{
+    unsigned long value = 2166136261UL;
+
+    while (length-- != 0) {
+	value = ((value ^ UChar(*name++)) * 16777619UL) & 0xffffffffUL;
+    }
+    return (unsigned) value;
+}
+
+static void
+free_tc_file(TC_FILE * target)
+{
+    TC_FILE **pp;
+
+    for (pp = &tc_files; *pp != 0; pp = &((*pp)->next)) {
+	if (*pp == target) {
+	    *pp = target->next;
+	    break;
+	}
+    }
+    free(target->path);
+    FreeIfNeeded(target->text);
+    FreeIfNeeded(target->records);
+    FreeIfNeeded(target->names);
+    free(target);
+}
+
+static void
+free_tc_entries(void)
+{
+    while (tc_entries != 0) {
+	TC_ENTRY *next = tc_entries->next;
+
+	_nc_free_termtype2(&(tc_entries->data));
+	free(tc_entries->name);
+	free(tc_entries);
+	tc_entries = next;
+    }
+}
+
+/*
+ * Return the end of the names field of a record, which is the first field in
+ * either termcap or terminfo syntax.
+ */
+static const char *
+tc_names_end(const char *s, const char *end)
+{
+    while (s < end
+	   && *s != ':'
+	   && *s != ','
+	   && *s != '\\'
+	   && *s != '\n') {
+	++s;
+    }
+    return s;
+}
+
+static void
+add_tc_name(TC_FILE * fp, const char *name, size_t length, int record)
+{
+    unsigned n = tc_hash(name, length) & fp->mask;
+
+    while (fp->names[n].name != 0) {
+	if (fp->names[n].length == length
+	    && !memcmp(fp->names[n].name, name, length))
+	    return;		/* the first record with a name is used */
+	n = (n + 1) & fp->mask;
+    }
+    fp->names[n].name = name;
+    fp->names[n].length = length;
+    fp->names[n].record = record;
+}
+
+/*
+ * Find the records in a termcap file, and index them by their names.  A
+ * record begins with a line which is not blank, a comment or a continuation,
+ * and extends to the beginning of the next record.
+ */
+static bool
+index_tc_file(TC_FILE * fp)
+{
+    const char *text = fp->text;
+    const char *end = text + fp->size;
+    const char *s;
+    int allocated = 0;
+    int line = 0;
+    int n;
+    unsigned total = 0;
+    unsigned size;
+    bool continued = FALSE;
+
+    for (s = text; s < end;) {
+	const char *eol = memchr(s, '\n', (size_t) (end - s));
+	const char *next = (eol != 0) ? (eol + 1) : end;
+
+	++line;
+	if (!continued && !isspace(UChar(*s)) && *s != '#') {
+	    if (fp->nrecords >= allocated) {
+		allocated = (allocated * 2) + 64;
+		fp->records = typeRealloc(TC_RECORD,
+					  (size_t) allocated,
+					  fp->records);
+		if (fp->records == 0)
+		    return FALSE;
+	    }
+	    if (fp->nrecords != 0) {
+		TC_RECORD *last = fp->records + fp->nrecords - 1;
+		last->length = (size_t) (s - text) - last->offset;
+	    }
+	    fp->records[fp->nrecords].offset = (size_t) (s - text);
+	    fp->records[fp->nrecords].line = line;
+	    fp->records[fp->nrecords].stamp = 0;
+	    fp->nrecords++;
+	}
+	if (*s == '#' || eol == 0 || eol == s) {
+	    continued = FALSE;
+	} else {
+	    const char *last = eol - 1;
+	    if (*last == '\r' && last > s)
+		--last;
+	    continued = (*last == '\\');
+	}
+	s = next;
+    }
+    if (fp->nrecords == 0)
+	return TRUE;
+    fp->records[fp->nrecords - 1].length = ((size_t) (end - text)
+					    - fp->records[fp->nrecords
+							  - 1].offset);
+
+    for (n = 0; n < fp->nrecords; ++n) {
+	const char *name = text + fp->records[n].offset;
+	const char *last = tc_names_end(name, end);
+
+	for (s = name; s < last; ++s) {
+	    if (*s == '|')
+		++total;
+	}
+	++total;
+    }
+    for (size = 64; size < (2 * total); size <<= 1) {
+	/* EMPTY */ ;
+    }
+    if ((fp->names = typeCalloc(TC_NAME, size)) == 0)
+	return FALSE;
+    fp->mask = size - 1;
+
+    for (n = 0; n < fp->nrecords; ++n) {
+	const char *name = text + fp->records[n].offset;
+	const char *last = tc_names_end(name, end);
+
+	for (s = name; s <= last; ++s) {
+	    if (s == last || *s == '|') {
+		if (s != name)
+		    add_tc_name(fp, name, (size_t) (s - name), n);
+		name = s + 1;
+	    }
+	}
+    }
+    return TRUE;
+}
+
+/*
+ * Return the index for the given termcap file, reading it if it is new or has
+ * changed.  Set the flag if the file was read, or if a file which was read
+ * before has been removed.
+ */
+static TC_FILE *
+get_tc_file(const char *path, bool *changed)
+{
+    TC_FILE *fp;
+    struct stat sb;
+    int fd;
+    bool found = (stat(path, &sb) == 0 && S_ISREG(sb.st_mode));
+
+    for (fp = tc_files; fp != 0; fp = fp->next) {
+	if (!strcmp(fp->path, path)) {
+	    if (found
+		&& fp->dev == sb.st_dev
+		&& fp->ino == sb.st_ino
+		&& fp->size == sb.st_size
+		&& fp->mtime == sb.st_mtime)
+		return fp;
+	    TR(TRACE_DATABASE, ("termcap %s has changed", path));
+	    free_tc_file(fp);
+	    *changed = TRUE;
+	    break;
+	}
+    }
+    if (!found)
+	return 0;
+
+    *changed = TRUE;
+    if ((fd = safe_open2(path, O_RDONLY)) < 0)
+	return 0;
+    if (fstat(fd, &sb) == 0
+	&& (fp = typeCalloc(TC_FILE, 1)) != 0) {
+	size_t want = (size_t) sb.st_size;
+	size_t have = 0;
+
+	if ((fp->path = strdup(path)) != 0
+	    && (fp->text = typeMalloc(char, want + 1)) != 0) {
+	    while (have < want) {
+		ssize_t got = read(fd, fp->text + have, want - have);
+		if (got <= 0)
+		    break;
+		have += (size_t) got;
+	    }
+	    fp->text[have] = '\0';
+	}
+	fp->dev = sb.st_dev;
+	fp->ino = sb.st_ino;
+	fp->size = (off_t) have;
+	fp->mtime = sb.st_mtime;
+	if (fp->text != 0
+	    && have == want
+	    && index_tc_file(fp)) {
+	    TR(TRACE_DATABASE, ("indexed %d termcap records in %s",
+				fp->nrecords, path));
+	    fp->next = tc_files;
+	    tc_files = fp;
+	} else {
+	    free_tc_file(fp);
+	    fp = 0;
+	}
+    }
+    close(fd);
+    return fp;
+}
+
+/*
+ * Parse a record, adding its entries to the list.  Comment lines are removed,
+ * since the scanner skips those only when reading a file.
+ */
+static void
+parse_tc_record(TC_FILE * fp, int n)
+{
+    TC_RECORD *rp = fp->records + n;
+    const char *src = fp->text + rp->offset;
+    const char *end = src + rp->length;
+    char *buffer;
+
+    rp->stamp = tc_stamp;
+    if ((buffer = typeMalloc(char, rp->length + 2)) != 0) {
+	char *dst = buffer;
+
+	while (src < end) {
+	    const char *eol = memchr(src, '\n', (size_t) (end - src));
+	    size_t length = ((eol != 0)
+			     ? (size_t) (eol + 1 - src)
+			     : (size_t) (end - src));
+
+	    if (*src != '#') {
+		memcpy(dst, src, length);
+		dst += length;
+	    }
+	    src += length;
+	}
+	if (dst == buffer || dst[-1] != '\n')
+	    *dst++ = '\n';
+	*dst = '\0';
+
+	TR(TRACE_DATABASE, ("parsing termcap record at %s:%d",
+			    fp->path, rp->line));
+	_nc_set_source(fp->path);
+	_nc_curr_line = rp->line - 1;
+	_nc_read_entry_source((FILE *) 0, buffer, FALSE, TRUE, NULLHOOK);
+	free(buffer);
+    }
+}
+
+/*
+ * Parse the first record with the given name in the list of files, unless
+ * this lookup has already parsed it.  Returns false if there is none.
+ */
+static bool
+load_tc_name(TC_FILE ** files, int count, const char *name)
+{
+    size_t length = strlen(name);
+    unsigned hash = tc_hash(name, length);
+    int j;
+
+    for (j = 0; j < count; ++j) {
+	TC_FILE *fp = files[j];
+	unsigned n;
+
+	if (fp->names == 0)
+	    continue;
+	for (n = hash & fp->mask;
+	     fp->names[n].name != 0;
+	     n = (n + 1) & fp->mask) {
+	    if (fp->names[n].length == length
+		&& !memcmp(fp->names[n].name, name, length)) {
+		int record = fp->names[n].record;
+
+		if (fp->records[record].stamp != tc_stamp)
+		    parse_tc_record(fp, record);
+		return TRUE;
+	    }
+	}
+    }
+    return FALSE;
+}
+#endif /* !USE_GETCAP */
+
+/*
+ * Look up a termcap entry, using the list of entries beginning at _nc_head,
+ * which the caller provides empty.
+ */
+static int
+read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
 {
     int found = TGETENT_NO;
     ENTRY *ep;
@@ -1028,7 +1390,6 @@ _nc_read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
      * This routine returns 1 if an entry is found, 0 if not found, and -1 if
      * the database is not accessible.
      */
-    FILE *fp;
     char *tc, *termpaths[MAXPATHS];
     int filecount = 0;
     int j, k;
@@ -1039,6 +1400,8 @@ _nc_read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
     char *copied = 0;
     char *cp;
     struct stat test_stat[MAXPATHS];
+    bool indexed = FALSE;
+    bool keep = TRUE;
 
     termpaths[filecount] = 0;
     if (use_terminfo_vars() && (tc = getenv("TERMCAP")) != 0) {
@@ -1120,28 +1483,71 @@ _nc_read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
 	_nc_read_entry_source((FILE *) 0, tc_buf, FALSE, FALSE, NULLHOOK);
 	free(tc_buf);
     } else {
+	TC_FILE *files[MAXPATHS];
+	TC_ENTRY *cached;
+	char *paths;
+	size_t need = 1;
+	int count = 0;
 	int i;
+	bool changed = FALSE;
 
 	for (i = 0; i < filecount; i++) {
-
 	    TR(TRACE_DATABASE, ("Looking for %s in %s", tn, termpaths[i]));
-	    if (_nc_access(termpaths[i], R_OK) == 0
-		&& (fp = safe_fopen(termpaths[i], "r")) != (FILE *) 0) {
-		_nc_set_source(termpaths[i]);
+	    if ((files[count] = get_tc_file(termpaths[i], &changed)) != 0)
+		++count;
+	    need += strlen(termpaths[i]) + 1;
+	}
 
-		/*
-		 * Suppress warning messages.  Otherwise you get 400 lines of
-		 * crap from archaic termcap files as ncurses complains about
-		 * all the obsolete capabilities.
-		 */
-		_nc_read_entry_source(fp, (char *) 0, FALSE, TRUE, NULLHOOK);
+	/*
+	 * Discard the converted entries if the files have changed, or a
+	 * different list of files is searched.
+	 */
+	if ((paths = typeMalloc(char, need)) != 0) {
+	    *paths = '\0';
+	    for (i = 0; i < filecount; i++) {
+		_nc_STRCAT(paths, termpaths[i], need);
+		_nc_STRCAT(paths, "\n", need);
+	    }
+	}
+	if (changed
+	    || paths == 0
+	    || tc_paths == 0
+	    || strcmp(paths, tc_paths)) {
+	    free_tc_entries();
+	    FreeIfNeeded(tc_paths);
+	    tc_paths = paths;
+	} else {
+	    free(paths);
+	}
+	FreeAndNull(copied);
+
+	for (cached = tc_entries; cached != 0; cached = cached->next) {
+	    if (!strcmp(cached->name, tn)) {
+		TR(TRACE_DATABASE, ("reusing termcap entry for %s", tn));
+		_nc_copy_termtype2(tp, &(cached->data));
+		return TGETENT_YES;
+	    }
+	}
+
+	if (count == 0)
+	    return TGETENT_ERR;
+
+	++tc_stamp;
+	if (!load_tc_name(files, count, tn))
+	    return TGETENT_NO;
+	for_entry_list(ep) {
+	    unsigned j;
 
-		(void) fclose(fp);
+	    for (j = 0; j < ep->nuses; ++j) {
+		if (ep->uses[j].name != 0
+		    && !load_tc_name(files, count, ep->uses[j].name)) {
+		    keep = FALSE;	/* may be a compiled entry */
+		}
 	    }
 	}
+	indexed = TRUE;
     }
-    if (copied != 0)
-	free(copied);
+    FreeIfNeeded(copied);
 #endif /* USE_GETCAP */
 
     if (_nc_head == 0)
@@ -1159,11 +1565,26 @@ _nc_read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
 	for_entry_list(ep) {
 	    if (_nc_name_match(ep->tterm.term_names, tn, "|:")) {
 		/*
-		 * Make a local copy of the terminal capabilities, delinked
-		 * from the list.
+		 * Make a local copy of the terminal capabilities.  The
+		 * resolved entry may point into the strings of those which it
+		 * uses, so the list is freed only after this.
 		 */
-		*tp = ep->tterm;
-		_nc_free_entry(_nc_head, &(ep->tterm));
+		_nc_copy_termtype2(tp, &(ep->tterm));
+#if !USE_GETCAP
+		if (indexed && keep) {
+		    TC_ENTRY *saved = typeCalloc(TC_ENTRY, 1);
+
+		    if (saved != 0) {
+			if ((saved->name = strdup(tn)) != 0) {
+			    _nc_copy_termtype2(&(saved->data), tp);
+			    saved->next = tc_entries;
+			    tc_entries = saved;
+			} else {
+			    free(saved);
+			}
+		    }
+		}
+#endif
 
 		/*
 		 * OK, now try to write the type to user's terminfo directory.
@@ -1179,6 +1600,7 @@ _nc_read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
 		 */
 #if USE_GETCAP_CACHE
 		(void) _nc_write_entry(tp);
+		_nc_close_writedir();
 #endif
 		found = TGETENT_YES;
 		break;
@@ -1191,6 +1613,30 @@ _nc_read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
 
     return (found);
 }
+
+/*
+ * The caller may be iterating over its own list of entries, e.g., tic
+ * resolving a "use=" through _nc_read_entry2().  Parse the termcap entries
+ * into a separate list, and free that when done.
+ */
+NCURSES_EXPORT(int)
+_nc_read_termcap_entry(const char *const tn, TERMTYPE2 *const tp)
+{
+    ENTRY *save_head = _nc_head;
+    ENTRY *save_tail = _nc_tail;
+    int result;
+
+    _nc_head = 0;
+    _nc_tail = 0;
+
+    result = read_termcap_entry(tn, tp);
+
+    _nc_free_entries(_nc_head);
+    _nc_head = save_head;
+    _nc_tail = save_tail;
+
+    return result;
+}
 #else
 extern
 NCURSES_EXPORT(void)
@@ -1200,3 +1646,16 @@ _nc_read_termcap(void)
 {
 }
 #endif /* PURE_TERMINFO */
+
+#if NO_LEAKS
+NCURSES_EXPORT(void)
+_nc_read_termcap_leaks(void)
+{
+#if !PURE_TERMINFO && !USE_GETCAP
+    free_tc_entries();
+    while (tc_files != 0)
+	free_tc_file(tc_files);
+    FreeAndNull(tc_paths);
+#endif
+}
+#endif
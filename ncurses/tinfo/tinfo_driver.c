@@ -1288,7 +1288,7 @@ drv_read(TERMINAL_CONTROL_BLOCK * TCB, int *buf)
 			 _nc_console_handle(sp->_ifd),
 			 buf);
 #else
-    n = (int) read(sp->_ifd, &c2, (size_t) 1);
+    n = _nc_read_input(sp, &c2, (size_t) 1);
 #endif
     _nc_set_read_thread(FALSE);
 #ifndef EXP_WIN32_DRIVER
@@ -186,7 +186,9 @@ make_db_root(const char *path)
     int rc;
     char fullpath[PATH_MAX];
 
-    if ((rc = make_db_path(fullpath, path, sizeof(fullpath))) == 0) {
+    if (_nc_is_index_path(path)) {
+	rc = _nc_access(path, W_OK);
+    } else if ((rc = make_db_path(fullpath, path, sizeof(fullpath))) == 0) {
 #if USE_HASHED_DB
 	DB *capdbp;
 
@@ -214,6 +216,416 @@ make_db_root(const char *path)
     return rc;
 }
 
+/*
+ * An indexed database is written all at once, when the caller is done with
+ * the entries.  Until then, the compiled entries are kept in memory, with the
+ * names and aliases which refer to them.
+ */
+typedef struct {
+    char *name;
+    unsigned entry;		/* index into index_entries[] */
+    unsigned order;		/* later keys replace earlier ones */
+} INDEX_KEY;
+
+typedef struct {
+    unsigned offset;		/* offset in index_data */
+    unsigned size;
+} INDEX_ENTRY;
+
+static bool indexed_db;
+static INDEX_KEY *index_keys;
+static size_t index_nkeys;
+static size_t index_maxkeys;
+static INDEX_ENTRY *index_entries;
+static size_t index_nentries;
+static size_t index_maxentries;
+static char *index_data;
+static size_t index_used;
+static size_t index_size;
+
+#define IndexLimit 0xffffffffUL
+
+static unsigned
+add_index_data(const char *data, size_t size)
+{
+    if (index_nentries >= index_maxentries) {
+	index_maxentries = (index_maxentries + 64) * 2;
+	TYPE_REALLOC(INDEX_ENTRY, index_maxentries, index_entries);
+    }
+    if (index_used + size > index_size) {
+	index_size = (index_used + size + BUFSIZ) * 2;
+	TYPE_REALLOC(char, index_size, index_data);
+    }
+    if (index_used + size > IndexLimit)
+	_nc_err_abort("%s: too much data for index", _nc_tic_dir(NULL));
+    memcpy(index_data + index_used, data, size);
+    index_entries[index_nentries].offset = (unsigned) index_used;
+    index_entries[index_nentries].size = (unsigned) size;
+    index_used += size;
+    return (unsigned) index_nentries++;
+}
+
+static void
+add_index_key(const char *name, unsigned entry)
+{
+    if (index_nkeys >= index_maxkeys) {
+	index_maxkeys = (index_maxkeys + 64) * 2;
+	TYPE_REALLOC(INDEX_KEY, index_maxkeys, index_keys);
+    }
+    if ((index_keys[index_nkeys].name = strdup(name)) == NULL)
+	_nc_err_abort(MSG_NO_MEMORY);
+    index_keys[index_nkeys].entry = entry;
+    index_keys[index_nkeys].order = (unsigned) index_nkeys + 1;
+    ++index_nkeys;
+}
+
+/*
+ * Add an entry, with its primary name and aliases, to the indexed database.
+ */
+static void
+add_index_entry(TERMTYPE2 *tp, const char *first_name, char *other_names)
+{
+    char buffer[MAX_ENTRY_SIZE];
+    unsigned limit = sizeof(buffer);
+    unsigned offset = 0;
+
+    if (_nc_write_object(tp, buffer, &offset, limit) == ERR) {
+	_nc_warning("entry is larger than %u bytes", limit);
+    } else {
+	unsigned entry = add_index_data(buffer, (size_t) offset);
+
+	add_index_key(first_name, entry);
+	while (*other_names != '\0') {
+	    char *ptr = other_names++;
+
+	    while (*other_names != '|' && *other_names != '\0')
+		other_names++;
+	    if (*other_names != '\0')
+		*(other_names++) = '\0';
+	    add_index_key(ptr, entry);
+	}
+	DEBUG(1, ("Indexed %s", first_name));
+    }
+}
+
+typedef struct {
+    size_t name;
+    size_t offset;
+    size_t size;
+} OLD_SLOT;
+
+static int
+compare_old_slots(const void *a, const void *b)
+{
+    const OLD_SLOT *p = (const OLD_SLOT *) a;
+    const OLD_SLOT *q = (const OLD_SLOT *) b;
+
+    return (p->offset > q->offset) - (p->offset < q->offset);
+}
+
+/*
+ * Keep the entries of an existing indexed database whose names are not
+ * redefined, like the files left in a directory by an earlier run.  Those keys
+ * sort before new keys with the same name, which replace them.
+ */
+static void
+merge_index_file(const char *path)
+{
+#define OldWord(n) (size_t) LOW_QUAD(image + (size_t) (n) * SIZEOF_32BITS)
+    FILE *fp;
+    char *image = NULL;
+    size_t length = 0;
+
+    if ((fp = safe_fopen(path, BIN_R)) != NULL) {
+	size_t got;
+
+	do {
+	    TYPE_REALLOC(char, length + BUFSIZ, image);
+	    got = fread(image + length, sizeof(char), (size_t) BUFSIZ, fp);
+	    length += got;
+	} while (got == BUFSIZ);
+	fclose(fp);
+    }
+
+    if (length >= INDEX_HEADER * SIZEOF_32BITS
+	&& OldWord(0) == INDEX_MAGIC
+	&& OldWord(1) == INDEX_VERSION) {
+	size_t words = length / SIZEOF_32BITS;
+	size_t keys = OldWord(2);
+	size_t buckets = OldWord(3);
+	size_t names = OldWord(4);
+	size_t names_size = OldWord(5);
+	size_t data = OldWord(6);
+	size_t data_size = OldWord(7);
+
+	if (keys < words
+	    && buckets < words
+	    && (INDEX_HEADER + buckets + INDEX_SLOT * keys) * SIZEOF_32BITS <= names
+	    && names <= data
+	    && names_size <= data - names
+	    && data <= length
+	    && data_size <= length - data) {
+	    OLD_SLOT *old;
+	    size_t used = 0;
+	    size_t n;
+	    unsigned entry = 0;
+
+	    TYPE_MALLOC(OLD_SLOT, keys + 1, old);
+	    for (n = 0; n < keys; ++n) {
+		size_t base = INDEX_HEADER + buckets + (INDEX_SLOT * n);
+
+		old[used].name = OldWord(base);
+		old[used].offset = OldWord(base + 1);
+		old[used].size = OldWord(base + 2);
+		if (old[used].name < names_size
+		    && memchr(image + names + old[used].name,
+			      '\0',
+			      names_size - old[used].name) != NULL
+		    && old[used].offset <= data_size
+		    && old[used].size <= data_size - old[used].offset)
+		    ++used;
+	    }
+
+	    /* aliases share the data of their entry */
+	    qsort(old, used, sizeof(OLD_SLOT), compare_old_slots);
+	    for (n = 0; n < used; ++n) {
+		if (n == 0 || old[n].offset != old[n - 1].offset)
+		    entry = add_index_data(image + data + old[n].offset,
+					   old[n].size);
+		add_index_key(image + names + old[n].name, entry);
+		index_keys[index_nkeys - 1].order = 0;
+	    }
+	    free(old);
+	}
+    }
+    free(image);
+#undef OldWord
+}
+
+static int
+compare_index_keys(const void *a, const void *b)
+{
+    const INDEX_KEY *p = (const INDEX_KEY *) a;
+    const INDEX_KEY *q = (const INDEX_KEY *) b;
+    int result = strcmp(p->name, q->name);
+
+    if (result == 0)
+	result = (p->order > q->order) - (p->order < q->order);
+    return result;
+}
+
+/*
+ * Build a minimal perfect hash of the keys, by "hash and displace":  the keys
+ * are grouped into buckets with one hash function, and for each bucket we look
+ * for a seed giving a second hash function which puts all of its keys into
+ * free slots.  The largest buckets are placed first, while most slots are free.
+ */
+static bool
+place_index_keys(size_t nbuckets, unsigned *seeds, unsigned *slots)
+{
+    bool result = TRUE;
+    size_t *counts;
+    size_t *starts;
+    size_t *members;
+    size_t *where;
+    size_t largest = 0;
+    size_t size;
+    size_t b;
+    size_t n;
+
+    TYPE_CALLOC(size_t, nbuckets + 1, counts);
+    TYPE_CALLOC(size_t, nbuckets + 1, starts);
+    TYPE_MALLOC(size_t, index_nkeys, members);
+
+    for (n = 0; n < index_nkeys; ++n) {
+	b = _nc_index_hash(0, index_keys[n].name) % nbuckets;
+	if (++counts[b] > largest)
+	    largest = counts[b];
+    }
+    for (b = 0; b < nbuckets; ++b)
+	starts[b + 1] = starts[b] + counts[b];
+    for (n = 0; n < index_nkeys; ++n) {
+	b = _nc_index_hash(0, index_keys[n].name) % nbuckets;
+	members[starts[b]++] = n;
+    }
+    for (b = 0; b < nbuckets; ++b) {
+	starts[b] -= counts[b];
+	seeds[b] = 0;
+    }
+    for (n = 0; n < index_nkeys; ++n)
+	slots[n] = (unsigned) IndexLimit;
+
+    TYPE_MALLOC(size_t, largest + 1, where);
+    for (size = largest; result && size != 0; --size) {
+	for (b = 0; result && b < nbuckets; ++b) {
+	    unsigned seed;
+
+	    if (counts[b] != size)
+		continue;
+	    for (seed = 1; seed < 0x100000; ++seed) {
+		size_t j, k;
+
+		for (j = 0; j < size; ++j) {
+		    const char *name = index_keys[members[starts[b] + j]].name;
+
+		    where[j] = _nc_index_hash(seed, name) % index_nkeys;
+		    if (slots[where[j]] != (unsigned) IndexLimit)
+			break;
+		    for (k = 0; k < j; ++k) {
+			if (where[k] == where[j])
+			    break;
+		    }
+		    if (k < j)
+			break;
+		}
+		if (j == size)
+		    break;
+	    }
+	    if (seed >= 0x100000) {
+		result = FALSE;
+	    } else {
+		seeds[b] = seed;
+		for (n = 0; n < size; ++n)
+		    slots[where[n]] = (unsigned) members[starts[b] + n];
+	    }
+	}
+    }
+    free(where);
+    free(members);
+    free(starts);
+    free(counts);
+    return result;
+}
+
+static void
+put_index_word(unsigned char *table, size_t n, size_t value)
+{
+    table += n * SIZEOF_32BITS;
+    table[0] = (unsigned char) (value & 0xff);
+    table[1] = (unsigned char) ((value >> 8) & 0xff);
+    table[2] = (unsigned char) ((value >> 16) & 0xff);
+    table[3] = (unsigned char) ((value >> 24) & 0xff);
+}
+
+/*
+ * Write the indexed database to a temporary file, and rename it to replace
+ * the old one, so that a reader sees either the old or new database.
+ */
+static void
+write_index_file(const char *path)
+{
+    char temp[PATH_MAX];
+    unsigned char *table;
+    unsigned *seeds;
+    unsigned *slots;
+    unsigned *moved;
+    char *names;
+    size_t nbuckets;
+    size_t names_size = 0;
+    size_t data_size = 0;
+    size_t tables;
+    size_t n, j;
+    FILE *fp;
+
+    if (strlen(path) + sizeof(".tmp") > sizeof(temp))
+	_nc_err_abort("%s: pathname is too long", path);
+    _nc_SPRINTF(temp, _nc_SLIMIT(sizeof(temp)) "%s.tmp", path);
+
+    /* keep only the last definition of each name */
+    qsort(index_keys, index_nkeys, sizeof(INDEX_KEY), compare_index_keys);
+    for (n = j = 0; n < index_nkeys; ++n) {
+	if (n + 1 < index_nkeys
+	    && !strcmp(index_keys[n].name, index_keys[n + 1].name)) {
+	    free(index_keys[n].name);
+	} else {
+	    index_keys[j++] = index_keys[n];
+	}
+    }
+    index_nkeys = j;
+
+    /* assign offsets to the entries which are still used */
+    TYPE_MALLOC(unsigned, index_nentries + 1, moved);
+    for (n = 0; n < index_nentries; ++n)
+	moved[n] = (unsigned) IndexLimit;
+    for (n = 0; n < index_nkeys; ++n) {
+	moved[index_keys[n].entry] = 0;
+	names_size += strlen(index_keys[n].name) + 1;
+    }
+    for (n = 0; n < index_nentries; ++n) {
+	if (moved[n] != (unsigned) IndexLimit) {
+	    moved[n] = (unsigned) data_size;
+	    data_size += index_entries[n].size;
+	}
+    }
+
+    TYPE_MALLOC(unsigned, index_nkeys, slots);
+    for (nbuckets = (index_nkeys / 4) + 1;; nbuckets *= 2) {
+	TYPE_MALLOC(unsigned, nbuckets, seeds);
+	if (place_index_keys(nbuckets, seeds, slots))
+	    break;
+	free(seeds);
+    }
+
+    tables = INDEX_HEADER + nbuckets + (INDEX_SLOT * index_nkeys);
+    if ((tables * SIZEOF_32BITS) + names_size + data_size > IndexLimit)
+	_nc_err_abort("%s: too much data for index", path);
+    TYPE_MALLOC(unsigned char, tables * SIZEOF_32BITS, table);
+    TYPE_MALLOC(char, names_size + 1, names);
+
+    put_index_word(table, 0, INDEX_MAGIC);
+    put_index_word(table, 1, INDEX_VERSION);
+    put_index_word(table, 2, index_nkeys);
+    put_index_word(table, 3, nbuckets);
+    put_index_word(table, 4, tables * SIZEOF_32BITS);
+    put_index_word(table, 5, names_size);
+    put_index_word(table, 6, (tables * SIZEOF_32BITS) + names_size);
+    put_index_word(table, 7, data_size);
+    for (n = 0; n < nbuckets; ++n)
+	put_index_word(table, INDEX_HEADER + n, seeds[n]);
+    for (n = j = 0; n < index_nkeys; ++n) {
+	const INDEX_KEY *key = &index_keys[slots[n]];
+	size_t base = INDEX_HEADER + nbuckets + (INDEX_SLOT * n);
+	size_t size = strlen(key->name) + 1;
+
+	put_index_word(table, base, j);
+	put_index_word(table, base + 1, moved[key->entry]);
+	put_index_word(table, base + 2, index_entries[key->entry].size);
+	memcpy(names + j, key->name, size);
+	j += size;
+    }
+
+    if ((fp = safe_fopen(temp, BIN_W)) == NULL) {
+	perror(temp);
+	_nc_syserr_abort("cannot open %s", temp);
+    }
+    (void) fwrite(table, SIZEOF_32BITS, tables, fp);
+    (void) fwrite(names, sizeof(char), names_size, fp);
+    for (n = 0; n < index_nentries; ++n) {
+	if (moved[n] != (unsigned) IndexLimit)
+	    (void) fwrite(index_data + index_entries[n].offset,
+			  sizeof(char),
+			  (size_t) index_entries[n].size,
+			  fp);
+    }
+    if (ferror(fp) | fclose(fp)) {
+	int myerr = errno;
+	unlink(temp);
+	_nc_syserr_abort("error writing %s: %s", temp, strerror(myerr));
+    }
+    if (rename(temp, path) != 0) {
+	int myerr = errno;
+	unlink(temp);
+	_nc_syserr_abort("cannot rename %s to %s: %s", temp, path, strerror(myerr));
+    }
+    DEBUG(1, ("Created %s with %lu names", path, (unsigned long) index_nkeys));
+
+    free(names);
+    free(table);
+    free(seeds);
+    free(slots);
+    free(moved);
+}
+
 /*
  * Set the write directory for compiled entries.
  */
@@ -253,16 +665,47 @@ _nc_set_writedir(const char *dir)
      * Note: because of this code, this logic should be exercised
      * *once only* per run.
      */
+    if (_nc_is_index_path(destination)) {
+	indexed_db = TRUE;
+	_nc_STRNCPY(actual, destination, sizeof(actual) - 1);
+	actual[sizeof(actual) - 1] = '\0';
+    } else {
 #if USE_HASHED_DB
-    make_db_path(actual, destination, sizeof(actual));
+	make_db_path(actual, destination, sizeof(actual));
 #else
-    if (chdir(_nc_tic_dir(destination)) < 0
-	|| getcwd(actual, sizeof(actual)) == NULL)
-	_nc_err_abort("%s: not a directory", destination);
+	if (chdir(_nc_tic_dir(destination)) < 0
+	    || getcwd(actual, sizeof(actual)) == NULL)
+	    _nc_err_abort("%s: not a directory", destination);
 #endif
+    }
     _nc_keep_tic_dir(actual);
 }
 
+/*
+ * Finish writing compiled entries.  An indexed database is written here,
+ * merging the entries from the existing file which were not replaced.
+ */
+NCURSES_EXPORT(void)
+_nc_close_writedir(void)
+{
+    if (indexed_db && index_nkeys != 0) {
+	const char *path = _nc_tic_dir(NULL);
+	size_t n;
+
+	merge_index_file(path);
+	write_index_file(path);
+
+	for (n = 0; n < index_nkeys; ++n)
+	    free(index_keys[n].name);
+	FreeAndNull(index_keys);
+	FreeAndNull(index_entries);
+	FreeAndNull(index_data);
+	index_nkeys = index_maxkeys = 0;
+	index_nentries = index_maxentries = 0;
+	index_used = index_size = 0;
+    }
+}
+
 /*
  *	Save the compiled version of a description in the filesystem.
  *
@@ -355,7 +798,12 @@ _nc_write_entry(TERMTYPE2 *const tp)
     DEBUG(7, ("Other names = '%s'", other_names));
 
     _nc_set_type(first_name);
+    _nc_forget_db();
 
+    if (indexed_db) {
+	add_index_entry(tp, first_name, other_names);
+	return;
+    }
 #if USE_HASHED_DB
     if (_nc_write_object(tp, buffer + 1, &offset, limit - 1) != ERR) {
 	DB *capdb = _nc_db_open(_nc_tic_dir(NULL), TRUE);
@@ -0,0 +1,400 @@
+/****************************************************************************
+ * Copyright 2024 agent                                                     *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ *  Author: agent                                                           *
+ ****************************************************************************/
+
+/*
+ *	cell_diff.c
+ *
+ *	Find the first and last cells which differ between two lines, e.g.,
+ *	newscr and curscr, or count the cells which differ.  When every byte
+ *	of a cell is significant to CharEq(), this compares the lines as
+ *	bytes, using SSE2 or AVX2 if the processor supports it.
+ */
+
+#include <curses.priv.h>
+
+MODULE_ID("$Id$")
+
+#if defined(__GNUC__) && (defined(__x86_64__) \
+			 || (defined(__i386__) && defined(__SSE2__)))
+#define USE_SSE2_DIFF 1
+#include <emmintrin.h>
+#if defined(__clang__) \
+    || (__GNUC__ > 4) \
+    || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)
+#define USE_AVX2_DIFF 1
+#include <immintrin.h>
+#endif
+#endif
+
+#ifndef USE_SSE2_DIFF
+#define USE_SSE2_DIFF 0
+#endif
+
+#ifndef USE_AVX2_DIFF
+#define USE_AVX2_DIFF 0
+#endif
+
+/*
+ * The byte-comparison is valid only if the cell has no padding, and CharEq()
+ * compares all of its members.
+ */
+#if USE_WIDEC_SUPPORT
+#define CELL_MEMBERS (sizeof(attr_t) \
+		      + (CCHARW_MAX * sizeof(wchar_t)) \
+		      if_EXT_COLORS(+ sizeof(int)))
+#else
+#define CELL_MEMBERS sizeof(chtype)
+#endif
+#define BytesComparable (sizeof(NCURSES_CH_T) == CELL_MEMBERS)
+
+#define CellBytes(count) ((size_t) (count) * sizeof(NCURSES_CH_T))
+
+typedef size_t (*MISMATCH) (const char *, const char *, size_t);
+
+/*
+ * Return the offset of the first byte which differs, or the length if none.
+ */
+static size_t
+first_mismatch_c(const char *a, const char *b, size_t len)
+{
+    size_t n = 0;
+
+    while (n + sizeof(size_t) <= len) {
+	size_t x, y;
+
+	memcpy(&x, a + n, sizeof(x));
+	memcpy(&y, b + n, sizeof(y));
+	if (x != y)
+	    break;
+	n += sizeof(size_t);
+    }
+    while (n < len && a[n] == b[n])
+	++n;
+    return n;
+}
+
+/*
+ * Return one past the offset of the last byte which differs, or zero if none.
+ */
+static size_t
+last_mismatch_c(const char *a, const char *b, size_t len)
+{
+    size_t n = len;
+
+    while (n >= sizeof(size_t)) {
+	size_t x, y;
+
+	memcpy(&x, a + n - sizeof(x), sizeof(x));
+	memcpy(&y, b + n - sizeof(y), sizeof(y));
+	if (x != y)
+	    break;
+	n -= sizeof(size_t);
+    }
+    while (n != 0 && a[n - 1] == b[n - 1])
+	--n;
+    return n;
+}
+
+#if USE_SSE2_DIFF
+#define SSE2_MASK 0xffffU
+#define SSE2_SAME(a,b) \
+	(unsigned) _mm_movemask_epi8( \
+		_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (const void *) (a)), \
+			       _mm_loadu_si128((const __m128i *) (const void *) (b))))
+
+static size_t
+first_mismatch_sse2(const char *a, const char *b, size_t len)
+{
+    size_t n = 0;
+
+    while (n + 16 <= len) {
+	unsigned same = SSE2_SAME(a + n, b + n);
+
+	if (same != SSE2_MASK)
+	    return n + (size_t) __builtin_ctz(~same & SSE2_MASK);
+	n += 16;
+    }
+    return n + first_mismatch_c(a + n, b + n, len - n);
+}
+
+static size_t
+last_mismatch_sse2(const char *a, const char *b, size_t len)
+{
+    size_t n = len;
+
+    while (n >= 16) {
+	unsigned same = SSE2_SAME(a + n - 16, b + n - 16);
+
+	if (same != SSE2_MASK)
+	    return n - 16 + (size_t) (32 - __builtin_clz(~same & SSE2_MASK));
+	n -= 16;
+    }
+    return last_mismatch_c(a, b, n);
+}
+#endif /* USE_SSE2_DIFF */
+
+#if USE_AVX2_DIFF
+#define AVX2_MASK 0xffffffffU
+#define AVX2_SAME(a,b) \
+	(unsigned) _mm256_movemask_epi8( \
+		_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) (const void *) (a)), \
+				  _mm256_loadu_si256((const __m256i *) (const void *) (b))))
+
+__attribute__((target("avx2")))
+static size_t
+first_mismatch_avx2(const char *a, const char *b, size_t len)
+{
+    size_t n = 0;
+
+    while (n + 32 <= len) {
+	unsigned same = AVX2_SAME(a + n, b + n);
+
+	if (same != AVX2_MASK)
+	    return n + (size_t) __builtin_ctz(~same);
+	n += 32;
+    }
+    return n + first_mismatch_sse2(a + n, b + n, len - n);
+}
+
+__attribute__((target("avx2")))
+static size_t
+last_mismatch_avx2(const char *a, const char *b, size_t len)
+{
+    size_t n = len;
+
+    while (n >= 32) {
+	unsigned same = AVX2_SAME(a + n - 32, b + n - 32);
+
+	if (same != AVX2_MASK)
+	    return n - 32 + (size_t) (32 - __builtin_clz(~same));
+	n -= 32;
+    }
+    return last_mismatch_sse2(a, b, n);
+}
+#endif /* USE_AVX2_DIFF */
+
+static size_t first_mismatch_init(const char *, const char *, size_t);
+static size_t last_mismatch_init(const char *, const char *, size_t);
+
+static MISMATCH first_mismatch = first_mismatch_init;
+static MISMATCH last_mismatch = last_mismatch_init;
+
+/*
+ * Choose the comparison functions on first use, according to the processor.
+ */
+static void
+choose_mismatch(void)
+{
+    MISMATCH first = first_mismatch_c;
+    MISMATCH last = last_mismatch_c;
+
+#if USE_SSE2_DIFF
+    first = first_mismatch_sse2;
+    last = last_mismatch_sse2;
+#endif
+#if USE_AVX2_DIFF
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+	first = first_mismatch_avx2;
+	last = last_mismatch_avx2;
+    }
+#endif
+    first_mismatch = first;
+    last_mismatch = last;
+}
+
+static size_t
+first_mismatch_init(const char *a, const char *b, size_t len)
+{
+    choose_mismatch();
+    return first_mismatch(a, b, len);
+}
+
+static size_t
+last_mismatch_init(const char *a, const char *b, size_t len)
+{
+    choose_mismatch();
+    return last_mismatch(a, b, len);
+}
+
+#if USE_SSE2_DIFF
+/*
+ * Count the 4-byte cells which differ, comparing four at a time.  If "step"
+ * is zero, compare each cell of "a" against the single cell "b".
+ */
+static int
+count_mismatch4_sse2(const char *a, const char *b, size_t step, int count)
+{
+    int result = 0;
+    int n = 0;
+    __m128i y = _mm_set1_epi32(0);
+
+    if (step == 0) {
+	int value;
+
+	memcpy(&value, b, sizeof(value));
+	y = _mm_set1_epi32(value);
+    }
+    while (n + 4 <= count) {
+	__m128i x = _mm_loadu_si128((const __m128i *) (const void *) a);
+	unsigned same;
+
+	if (step != 0)
+	    y = _mm_loadu_si128((const __m128i *) (const void *) b);
+	same = (unsigned) _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(x, y)));
+	result += 4 - __builtin_popcount(same);
+	a += 16;
+	b += 4 * step;
+	n += 4;
+    }
+    while (n < count) {
+	if (memcmp(a, b, (size_t) 4))
+	    ++result;
+	a += 4;
+	b += step;
+	n += 1;
+    }
+    return result;
+}
+#define Count4Cells (USE_SSE2_DIFF \
+		     && BytesComparable \
+		     && sizeof(NCURSES_CH_T) == 4)
+#else
+#define Count4Cells 0
+#define count_mismatch4_sse2(a, b, step, count) 0
+#endif
+
+/*
+ * Return the index of the first cell which differs between the two lines,
+ * or "count" if they are the same.
+ */
+NCURSES_EXPORT(int)
+_nc_diff_first(const NCURSES_CH_T *a, const NCURSES_CH_T *b, int count)
+{
+    int result = 0;
+
+    if (count > 0) {
+	if (BytesComparable) {
+	    size_t n = first_mismatch((const char *) a,
+				      (const char *) b,
+				      CellBytes(count));
+	    result = (int) (n / sizeof(NCURSES_CH_T));
+	} else {
+	    while (result < count && CharEq(a[result], b[result]))
+		++result;
+	}
+    }
+    return result;
+}
+
+/*
+ * Return the index of the last cell which differs between the two lines,
+ * or -1 if they are the same.
+ */
+NCURSES_EXPORT(int)
+_nc_diff_last(const NCURSES_CH_T *a, const NCURSES_CH_T *b, int count)
+{
+    int result = -1;
+
+    if (count > 0) {
+	if (BytesComparable) {
+	    size_t n = last_mismatch((const char *) a,
+				     (const char *) b,
+				     CellBytes(count));
+	    if (n != 0)
+		result = (int) ((n - 1) / sizeof(NCURSES_CH_T));
+	} else {
+	    result = count - 1;
+	    while (result >= 0 && CharEq(a[result], b[result]))
+		--result;
+	}
+    }
+    return result;
+}
+
+/*
+ * Return the number of cells which differ between the two lines.
+ */
+NCURSES_EXPORT(int)
+_nc_diff_count(const NCURSES_CH_T *a, const NCURSES_CH_T *b, int count)
+{
+    int result = 0;
+
+    if (Count4Cells) {
+	result = count_mismatch4_sse2((const char *) a,
+				      (const char *) b,
+				      sizeof(NCURSES_CH_T),
+				      count);
+    } else {
+	int n = 0;
+
+	while (n < count) {
+	    n += _nc_diff_first(a + n, b + n, count - n);
+	    while (n < count && !CharEq(a[n], b[n])) {
+		++result;
+		++n;
+	    }
+	}
+    }
+    return result;
+}
+
+/*
+ * Return the number of cells in the line which differ from the given cell.
+ */
+NCURSES_EXPORT(int)
+_nc_diff_count_char(const NCURSES_CH_T *a, const NCURSES_CH_T *cell, int count)
+{
+    int result = 0;
+
+    if (Count4Cells) {
+	result = count_mismatch4_sse2((const char *) a,
+				      (const char *) cell,
+				      (size_t) 0,
+				      count);
+    } else {
+	int n = 0;
+
+	while (n < count) {
+	    if (CharEq(a[n], *cell)) {
+		/* the cells following a[n] which match it also match "cell" */
+		++n;
+		n += _nc_diff_first(a + n, a + n - 1, count - n);
+	    } else {
+		++result;
+		++n;
+	    }
+	}
+    }
+    return result;
+}
@@ -60,7 +60,7 @@ HOW TO TEST THIS:
 Use the following production:
 
 hashmap: hashmap.c
-	$(CC) -g -DHASHDEBUG hashmap.c hardscroll.c ../objects/lib_trace.o -o hashmap
+	$(CC) -g -DHASHDEBUG hashmap.c hardscroll.c ../objects/cell_diff.o ../objects/lib_trace.o -o hashmap
 
 AUTHOR
     Eric S. Raymond <esr@snark.thyrsus.com>, May 1996
@@ -119,6 +119,17 @@ static NCURSES_CH_T newtext[MAXLINES][TEXTWIDTH(sp)];
 
 static const NCURSES_CH_T blankchar = NewChar(BLANK_TEXT);
 
+/*
+ * The hash is the polynomial sum of HASH_VAL(text[i]) * 33^(n-1-i), i.e.,
+ *	result = (result << 5) + result + HASH_VAL(ch)
+ * for each cell.  Computing four cells at a time shortens the dependency
+ * chain, giving the same result.
+ */
+#define HASH_MUL1	33UL
+#define HASH_MUL2	(HASH_MUL1 * HASH_MUL1)
+#define HASH_MUL3	(HASH_MUL2 * HASH_MUL1)
+#define HASH_MUL4	(HASH_MUL2 * HASH_MUL2)
+
 static NCURSES_INLINE unsigned long
 hash(SCREEN *sp, const NCURSES_CH_T *text)
 {
@@ -126,6 +137,28 @@ hash(SCREEN *sp, const NCURSES_CH_T *text)
     unsigned long result = 0;
     (void) sp;
 
+    for (i = TEXTWIDTH(sp); i >= 4; i -= 4, text += 4) {
+	result = (result * HASH_MUL4
+		  + (unsigned long) HASH_VAL(text[0]) * HASH_MUL3
+		  + (unsigned long) HASH_VAL(text[1]) * HASH_MUL2
+		  + (unsigned long) HASH_VAL(text[2]) * HASH_MUL1
+		  + (unsigned long) HASH_VAL(text[3]));
+    }
+    for (; i > 0; i--) {
+	NCURSES_CH_T ch = *text++;
+	result += (result << 5) + (unsigned long) HASH_VAL(ch);
+    }
+    return result;
+}
+
+#ifdef HASH_VERIFY
+static unsigned long
+hash_c(SCREEN *sp, const NCURSES_CH_T *text)
+{
+    int i;
+    unsigned long result = 0;
+    (void) sp;
+
     for (i = TEXTWIDTH(sp); i > 0; i--) {
 	NCURSES_CH_T ch = *text++;
 	result += (result << 5) + (unsigned long) HASH_VAL(ch);
@@ -133,9 +166,8 @@ hash(SCREEN *sp, const NCURSES_CH_T *text)
     return result;
 }
 
-/* approximate update cost */
 static int
-update_cost(SCREEN *sp, NCURSES_CH_T *from, NCURSES_CH_T *to)
+update_cost_c(SCREEN *sp, const NCURSES_CH_T *from, const NCURSES_CH_T *to)
 {
     int cost = 0;
     int i;
@@ -147,22 +179,45 @@ update_cost(SCREEN *sp, NCURSES_CH_T *from, NCURSES_CH_T *to)
 
     return cost;
 }
+#endif
+
+/* approximate update cost */
+static int
+update_cost(SCREEN *sp, NCURSES_CH_T *from, NCURSES_CH_T *to)
+{
+    int cost = _nc_diff_count(from, to, TEXTWIDTH(sp));
+    (void) sp;
+
+#ifdef HASH_VERIFY
+    if (cost != update_cost_c(sp, from, to))
+	fprintf(stderr, "error in update_cost\n");
+#endif
+    return cost;
+}
 
 static int
 update_cost_from_blank(SCREEN *sp, NCURSES_CH_T *to)
 {
-    int cost = 0;
-    int i;
+    int cost;
     NCURSES_CH_T blank = blankchar;
     (void) sp;
 
     if (back_color_erase)
 	SetPair(blank, GetPair(stdscr->_nc_bkgd));
 
-    for (i = TEXTWIDTH(sp); i > 0; i--, to++)
-	if (!(CharEq(blank, *to)))
-	    cost++;
-
+    cost = _nc_diff_count_char(to, &blank, TEXTWIDTH(sp));
+#ifdef HASH_VERIFY
+    {
+	int check = 0;
+	int i;
+
+	for (i = 0; i < TEXTWIDTH(sp); i++)
+	    if (!(CharEq(blank, to[i])))
+		check++;
+	if (cost != check)
+	    fprintf(stderr, "error in update_cost_from_blank\n");
+    }
+#endif
     return cost;
 }
 
@@ -195,6 +250,243 @@ cost_effective(SCREEN *sp, const int from, const int to, const int blank)
 	? TRUE : FALSE;
 }
 
+/*
+ * Alternative to the unique-pair matching done in _nc_hash_map(), selected by
+ * the NCURSES_PATIENCE_SCROLL environment variable.  This is "patience diff":
+ * lines whose hash is unique in both the old and new ranges are candidate
+ * anchors, and the longest increasing subsequence of those (in new-line order,
+ * by old-line number) is kept, so that the matches never cross.  Then repeat
+ * for the ranges between anchors, after matching equal lines at the ends of
+ * each range.
+ *
+ * Log-tails may have no unique lines at all, e.g., repeated blank lines or
+ * heartbeat messages.  If a range has no unique lines, look instead for unique
+ * windows of 2, 4, 8 or 16 consecutive lines.
+ */
+#define PLAN_WINDOW	16
+#define PLAN_MIX(a,b)	((a) * 1000003UL + (b))
+
+typedef struct {
+    unsigned long hashval;
+    int is_new;
+    int index;
+} PLAN_LINE;
+
+typedef struct _plan_data {
+    int length;			/* number of lines allocated */
+    PLAN_LINE *sorted;		/* windows of a range, sorted by hash */
+    unsigned long *oldwin;	/* hash of window starting at old line */
+    unsigned long *newwin;	/* hash of window starting at new line */
+    int *match;			/* old window uniquely matching a new window */
+    int *tails;			/* tails[k] ends increasing subsequence k+1 */
+    int *prev;			/* predecessor in increasing subsequence */
+} PLAN_DATA;
+
+static int
+compare_plan_lines(const void *a, const void *b)
+{
+    const PLAN_LINE *p = (const PLAN_LINE *) a;
+    const PLAN_LINE *q = (const PLAN_LINE *) b;
+    int result;
+
+    if (p->hashval != q->hashval)
+	result = (p->hashval < q->hashval) ? -1 : 1;
+    else if (p->is_new != q->is_new)
+	result = p->is_new - q->is_new;
+    else
+	result = p->index - q->index;
+    return result;
+}
+
+/*
+ * Find the windows of the given width which are unique in both ranges, and
+ * mark the lines of the longest increasing subsequence of those in OLDNUM.
+ * Returns the number of windows marked.
+ */
+static int
+patience_anchors(SCREEN *sp, PLAN_DATA * plan, int width,
+		 int olo, int ohi, int nlo, int nhi)
+{
+    int count = 0;
+    int longest = 0;
+    int marked = 0;
+    int o_end = olo;
+    int n_end = nlo;
+    int n, k;
+
+    for (n = olo; n + width <= ohi; ++n, ++count) {
+	plan->sorted[count].hashval = plan->oldwin[n];
+	plan->sorted[count].is_new = 0;
+	plan->sorted[count].index = n;
+    }
+    for (n = nlo; n + width <= nhi; ++n, ++count) {
+	plan->sorted[count].hashval = plan->newwin[n];
+	plan->sorted[count].is_new = 1;
+	plan->sorted[count].index = n;
+	plan->match[n] = _NEWINDEX;
+    }
+    qsort(plan->sorted, (size_t) count, sizeof(PLAN_LINE), compare_plan_lines);
+    for (n = 0; n < count; n = k) {
+	for (k = n + 1; k < count; ++k) {
+	    if (plan->sorted[k].hashval != plan->sorted[n].hashval)
+		break;
+	}
+	if (k - n == 2 && !plan->sorted[n].is_new && plan->sorted[n + 1].is_new)
+	    plan->match[plan->sorted[n + 1].index] = plan->sorted[n].index;
+    }
+
+    for (n = nlo; n + width <= nhi; ++n) {
+	int lo = 0;
+	int hi = longest;
+
+	if (plan->match[n] == _NEWINDEX)
+	    continue;
+	while (lo < hi) {
+	    int mid = (lo + hi) / 2;
+	    if (plan->match[plan->tails[mid]] < plan->match[n])
+		lo = mid + 1;
+	    else
+		hi = mid;
+	}
+	plan->prev[n] = (lo > 0) ? plan->tails[lo - 1] : _NEWINDEX;
+	plan->tails[lo] = n;
+	if (lo == longest)
+	    ++longest;
+    }
+    if (longest == 0)
+	return 0;
+
+    /* list the subsequence in order, reusing "tails" */
+    for (k = longest, n = plan->tails[longest - 1]; k > 0; n = plan->prev[n])
+	plan->tails[--k] = n;
+
+    /*
+     * Windows may overlap.  Keep those which have the same shift as the
+     * previous one, or which do not overlap it.
+     */
+    for (k = 0; k < longest; ++k) {
+	int nn = plan->tails[k];
+	int oo = plan->match[nn];
+	int j;
+
+	if (marked
+	    && (nn < n_end || oo < o_end)
+	    && (oo - nn) != (o_end - n_end))
+	    continue;
+	for (j = Max(0, n_end - nn); j < width; ++j)
+	    OLDNUM(sp, nn + j) = oo + j;
+	n_end = nn + width;
+	o_end = oo + width;
+	++marked;
+    }
+    return marked;
+}
+
+static void
+patience_range(SCREEN *sp, PLAN_DATA * plan, int olo, int ohi, int nlo, int nhi)
+{
+    int width;
+    int n, k;
+
+    /* match equal lines at each end of the ranges */
+    while (olo < ohi && nlo < nhi && oldhash(sp)[olo] == newhash(sp)[nlo])
+	OLDNUM(sp, nlo++) = olo++;
+    while (olo < ohi && nlo < nhi && oldhash(sp)[ohi - 1] == newhash(sp)[nhi - 1])
+	OLDNUM(sp, --nhi) = --ohi;
+    if (olo >= ohi || nlo >= nhi)
+	return;
+
+    for (n = olo; n < ohi; ++n)
+	plan->oldwin[n] = oldhash(sp)[n];
+    for (n = nlo; n < nhi; ++n)
+	plan->newwin[n] = newhash(sp)[n];
+
+    for (width = 1;; width *= 2) {
+	if (patience_anchors(sp, plan, width, olo, ohi, nlo, nhi))
+	    break;
+	if (width >= PLAN_WINDOW
+	    || 2 * width > ohi - olo
+	    || 2 * width > nhi - nlo)
+	    return;
+	/* combine adjacent windows, giving windows twice as wide */
+	for (n = olo; n + 2 * width <= ohi; ++n)
+	    plan->oldwin[n] = PLAN_MIX(plan->oldwin[n], plan->oldwin[n + width]);
+	for (n = nlo; n + 2 * width <= nhi; ++n)
+	    plan->newwin[n] = PLAN_MIX(plan->newwin[n], plan->newwin[n + width]);
+    }
+
+    /* repeat for the ranges between anchors */
+    for (n = nlo, k = nlo; k < nhi; ++k) {
+	if (OLDNUM(sp, k) != _NEWINDEX) {
+	    patience_range(sp, plan, olo, OLDNUM(sp, k), n, k);
+	    olo = OLDNUM(sp, k) + 1;
+	    n = k + 1;
+	}
+    }
+    patience_range(sp, plan, olo, ohi, n, nhi);
+}
+
+/*
+ * The work arrays are kept with the screen, in a single block which is
+ * reallocated only when the screen has more lines.
+ */
+static PLAN_DATA *
+patience_data(SCREEN *sp, int limit)
+{
+    PLAN_DATA *plan = sp->_plan_data;
+
+    if (plan == 0 || plan->length < limit) {
+	size_t want = (sizeof(PLAN_DATA)
+		       + (size_t) limit * (2 * sizeof(PLAN_LINE)
+					   + 2 * sizeof(unsigned long)
+					   + 3 * sizeof(int)));
+
+	FreeIfNeeded(plan);
+	if ((plan = malloc(want)) != 0) {
+	    plan->length = limit;
+	    plan->sorted = (PLAN_LINE *) (plan + 1);
+	    plan->oldwin = (unsigned long *) (plan->sorted + 2 * limit);
+	    plan->newwin = plan->oldwin + limit;
+	    plan->match = (int *) (plan->newwin + limit);
+	    plan->tails = plan->match + limit;
+	    plan->prev = plan->tails + limit;
+	}
+	sp->_plan_data = plan;
+    }
+    return plan;
+}
+
+/*
+ * Returns true if the patience planner could be used, setting OLDNUM.
+ */
+static bool
+patience_plan(SCREEN *sp)
+{
+    PLAN_DATA *plan;
+    bool result = FALSE;
+    int limit = screen_lines(sp);
+    int i;
+
+    if ((plan = patience_data(sp, limit)) != 0) {
+	for (i = 0; i < limit; i++)
+	    OLDNUM(sp, i) = _NEWINDEX;
+	patience_range(sp, plan, 0, limit, 0, limit);
+
+	/* as with unique pairs, do not mark lines with offset 0 */
+	for (i = 0; i < limit; i++) {
+	    if (OLDNUM(sp, i) == i) {
+		OLDNUM(sp, i) = _NEWINDEX;
+	    } else if (OLDNUM(sp, i) != _NEWINDEX) {
+		TR(TRACE_UPDATE | TRACE_MOVE,
+		   ("new line %d is hash-identical to old line %d (patience)",
+		    i, OLDNUM(sp, i)));
+	    }
+	}
+	result = TRUE;
+    }
+    return result;
+}
+
 static void
 grow_hunks(SCREEN *sp)
 {
@@ -334,54 +626,60 @@ NCURSES_SP_NAME(_nc_hash_map) (NCURSES_SP_DCL0)
 	    fprintf(stderr, "error in newhash[%d]\n", i);
 	if (oldhash(SP_PARM)[i] != hash(SP_PARM, OLDTEXT(SP_PARM, i)))
 	    fprintf(stderr, "error in oldhash[%d]\n", i);
+	if (newhash(SP_PARM)[i] != hash_c(SP_PARM, NEWTEXT(SP_PARM, i)))
+	    fprintf(stderr, "error in hash of new line %d\n", i);
     }
 #endif
 
-    /*
-     * Set up and count line-hash values.
-     */
-    memset(hashtab(SP_PARM), '\0',
-	   sizeof(*(hashtab(SP_PARM)))
-	   * ((size_t) screen_lines(SP_PARM) + 1) * 2);
-    for (i = 0; i < screen_lines(SP_PARM); i++) {
-	unsigned long hashval = oldhash(SP_PARM)[i];
-
-	for (hsp = hashtab(SP_PARM); hsp->hashval; hsp++)
-	    if (hsp->hashval == hashval)
-		break;
-	hsp->hashval = hashval;	/* in case this is a new entry */
-	hsp->oldcount++;
-	hsp->oldindex = i;
-    }
-    for (i = 0; i < screen_lines(SP_PARM); i++) {
-	unsigned long hashval = newhash(SP_PARM)[i];
+    if (SP_PARM->_patience_scroll && patience_plan(SP_PARM)) {
+	TR(TRACE_UPDATE | TRACE_MOVE, ("used patience planner"));
+    } else {
+	/*
+	 * Set up and count line-hash values.
+	 */
+	memset(hashtab(SP_PARM), '\0',
+	       sizeof(*(hashtab(SP_PARM)))
+	       * ((size_t) screen_lines(SP_PARM) + 1) * 2);
+	for (i = 0; i < screen_lines(SP_PARM); i++) {
+	    unsigned long hashval = oldhash(SP_PARM)[i];
 
-	for (hsp = hashtab(SP_PARM); hsp->hashval; hsp++)
-	    if (hsp->hashval == hashval)
-		break;
-	hsp->hashval = hashval;	/* in case this is a new entry */
-	hsp->newcount++;
-	hsp->newindex = i;
+	    for (hsp = hashtab(SP_PARM); hsp->hashval; hsp++)
+		if (hsp->hashval == hashval)
+		    break;
+	    hsp->hashval = hashval;	/* in case this is a new entry */
+	    hsp->oldcount++;
+	    hsp->oldindex = i;
+	}
+	for (i = 0; i < screen_lines(SP_PARM); i++) {
+	    unsigned long hashval = newhash(SP_PARM)[i];
 
-	OLDNUM(SP_PARM, i) = _NEWINDEX;		/* initialize old indices array */
-    }
+	    for (hsp = hashtab(SP_PARM); hsp->hashval; hsp++)
+		if (hsp->hashval == hashval)
+		    break;
+	    hsp->hashval = hashval;	/* in case this is a new entry */
+	    hsp->newcount++;
+	    hsp->newindex = i;
 
-    /*
-     * Mark line pairs corresponding to unique hash pairs.
-     *
-     * We don't mark lines with offset 0, because it can make fail
-     * extending hunks by cost_effective. Otherwise, it does not
-     * have any side effects.
-     */
-    for (hsp = hashtab(SP_PARM); hsp->hashval; hsp++)
-	if (hsp->oldcount == 1 && hsp->newcount == 1
-	    && hsp->oldindex != hsp->newindex) {
-	    TR(TRACE_UPDATE | TRACE_MOVE,
-	       ("new line %d is hash-identical to old line %d (unique)",
-		hsp->newindex, hsp->oldindex));
-	    OLDNUM(SP_PARM, hsp->newindex) = hsp->oldindex;
+	    OLDNUM(SP_PARM, i) = _NEWINDEX;		/* initialize old indices array */
 	}
 
+	/*
+	 * Mark line pairs corresponding to unique hash pairs.
+	 *
+	 * We don't mark lines with offset 0, because it can make fail
+	 * extending hunks by cost_effective. Otherwise, it does not
+	 * have any side effects.
+	 */
+	for (hsp = hashtab(SP_PARM); hsp->hashval; hsp++)
+	    if (hsp->oldcount == 1 && hsp->newcount == 1
+		&& hsp->oldindex != hsp->newindex) {
+		TR(TRACE_UPDATE | TRACE_MOVE,
+		   ("new line %d is hash-identical to old line %d (unique)",
+		    hsp->newindex, hsp->oldindex));
+		OLDNUM(SP_PARM, hsp->newindex) = hsp->oldindex;
+	    }
+    }
+
     grow_hunks(SP_PARM);
 
     /*
@@ -483,6 +781,7 @@ usage(void)
 	"o  use following letters as text of old lines",
 	"d  dump state of test arrays",
 	"h  apply hash mapper and see scroll optimization",
+	"p  toggle the patience-diff planner",
 	"?  this message"
     };
     size_t n;
@@ -580,6 +879,12 @@ main(int argc GCC_UNUSED, char *argv[]GCC_UNUSED)
 	    _nc_scroll_optimize();
 	    (void) fputs("Done.\n", stderr);
 	    break;
+
+	case 'p':		/* toggle the patience-diff planner */
+	    SP->_patience_scroll = !SP->_patience_scroll;
+	    fprintf(stderr, "patience planner %s\n",
+		    SP->_patience_scroll ? "on" : "off");
+	    break;
 	default:
 	case '?':
 	    usage();
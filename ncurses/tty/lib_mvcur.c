@@ -182,41 +182,78 @@ static float diff;
 
 #define OPT_SIZE 512
 
-static int normalized_cost(NCURSES_SP_DCLx const char *const cap, int affcnt);
-
 /****************************************************************************
  *
  * Initialization/wrapup (including cost pre-computation)
  *
  ****************************************************************************/
 
-#ifdef TRACE
-static int
-trace_cost_of(NCURSES_SP_DCLx const char *capname, const char *cap, int affcnt)
+/*
+ * Count the characters which a capability sends, and the padding which it
+ * asks for, in 10ths of milliseconds.
+ */
+static void
+measure_cap(const char *const cap, int affcnt, int *chars, float *padding)
 {
-    int result = NCURSES_SP_NAME(_nc_msec_cost) (NCURSES_SP_ARGx cap, affcnt);
-    TR(TRACE_CHARPUT | TRACE_MOVE,
-       ("CostOf %s %d %s", capname, result, _nc_visbuf(cap)));
-    return result;
+    const char *cp;
+
+    *chars = 0;
+    *padding = 0.0;
+    for (cp = cap; *cp; cp++) {
+	/* extract padding, either mandatory or required */
+	if (cp[0] == '$' && cp[1] == '<' && strchr(cp, '>')) {
+	    float number = 0.0;
+	    int state = 0;
+
+	    for (cp += 2; *cp != '>'; cp++) {
+		if (isdigit(UChar(*cp))) {
+		    switch (state) {
+		    case 0:
+			number = number * 10 + (float) (*cp - '0');
+			break;
+		    case 2:
+			number += (float) ((*cp - '0') / 10.0);
+			++state;
+			break;
+		    }
+		} else if (*cp == '*') {
+		    /* padding is always a suffix */
+		    if (state < 4) {
+			number *= (float) affcnt;
+			state = 4;
+		    }
+		} else if (*cp == '.') {
+		    /* a single decimal point is allowed */
+		    state = (state == 0) ? 2 : 3;
+		}
+		if (number > MAX_DELAY_MSECS) {
+		    number = MAX_DELAY_MSECS;
+		    break;
+		}
+	    }
+	    *padding += number * 10;
+	} else {
+	    ++(*chars);
+	}
+    }
 }
-#define CostOf(cap,affcnt) trace_cost_of(NCURSES_SP_ARGx #cap, cap, affcnt)
 
+/*
+ * Combine the measurements of a capability with the time to send a character.
+ */
 static int
-trace_normalized_cost(NCURSES_SP_DCLx const char *capname, const char *cap, int affcnt)
+cost_of_measure(NCURSES_SP_DCLx int chars, float padding)
 {
-    int result = normalized_cost(NCURSES_SP_ARGx cap, affcnt);
-    TR(TRACE_CHARPUT | TRACE_MOVE,
-       ("NormalizedCost %s %d %s", capname, result, _nc_visbuf(cap)));
-    return result;
-}
-#define NormalizedCost(cap,affcnt) trace_normalized_cost(NCURSES_SP_ARGx #cap, cap, affcnt)
-
-#else
-
-#define CostOf(cap,affcnt) NCURSES_SP_NAME(_nc_msec_cost)(NCURSES_SP_ARGx cap, affcnt)
-#define NormalizedCost(cap,affcnt) normalized_cost(NCURSES_SP_ARGx cap, affcnt)
+    float cum_cost = 0.0;
 
+#if NCURSES_NO_PADDING
+    if (!GetNoPadding(SP_PARM))
 #endif
+	cum_cost += padding;
+    if (SP_PARM)
+	cum_cost += (float) (chars * SP_PARM->_char_padding);
+    return ((int) cum_cost);
+}
 
 NCURSES_EXPORT(int)
 NCURSES_SP_NAME(_nc_msec_cost) (NCURSES_SP_DCLx const char *const cap, int affcnt)
@@ -225,52 +262,11 @@ NCURSES_SP_NAME(_nc_msec_cost) (NCURSES_SP_DCLx const char *const cap, int affcn
     if (cap == 0)
 	return (INFINITY);
     else {
-	const char *cp;
-	float cum_cost = 0.0;
-
-	for (cp = cap; *cp; cp++) {
-	    /* extract padding, either mandatory or required */
-	    if (cp[0] == '$' && cp[1] == '<' && strchr(cp, '>')) {
-		float number = 0.0;
-		int state = 0;
-
-		for (cp += 2; *cp != '>'; cp++) {
-		    if (isdigit(UChar(*cp))) {
-			switch (state) {
-			case 0:
-			    number = number * 10 + (float) (*cp - '0');
-			    break;
-			case 2:
-			    number += (float) ((*cp - '0') / 10.0);
-			    ++state;
-			    break;
-			}
-		    } else if (*cp == '*') {
-			/* padding is always a suffix */
-			if (state < 4) {
-			    number *= (float) affcnt;
-			    state = 4;
-			}
-		    } else if (*cp == '.') {
-			/* a single decimal point is allowed */
-			state = (state == 0) ? 2 : 3;
-		    }
-		    if (number > MAX_DELAY_MSECS) {
-			number = MAX_DELAY_MSECS;
-			break;
-		    }
-		}
-
-#if NCURSES_NO_PADDING
-		if (!GetNoPadding(SP_PARM))
-#endif
-		    cum_cost += number * 10;
-	    } else if (SP_PARM) {
-		cum_cost += (float) SP_PARM->_char_padding;
-	    }
-	}
+	int chars;
+	float padding;
 
-	return ((int) cum_cost);
+	measure_cap(cap, affcnt, &chars, &padding);
+	return cost_of_measure(NCURSES_SP_ARGx chars, padding);
     }
 }
 
@@ -283,15 +279,214 @@ _nc_msec_cost(const char *const cap, int affcnt)
 #endif
 
 static int
-normalized_cost(NCURSES_SP_DCLx const char *const cap, int affcnt)
+normalize_cost(NCURSES_SP_DCLx int cost)
 /* compute the effective character-count for an operation (round up) */
 {
-    int cost = NCURSES_SP_NAME(_nc_msec_cost) (NCURSES_SP_ARGx cap, affcnt);
     if (cost != INFINITY)
 	cost = (cost + SP_PARM->_char_padding - 1) / SP_PARM->_char_padding;
     return cost;
 }
 
+/*
+ * Most of the work of compute_costs() is in expanding the parameterized
+ * capabilities with sample values.  The characters and padding of those
+ * samples depend only on the terminal description, so they are kept in a
+ * profile, which is shared by the screens whose terminals use the same
+ * compiled entry (see read_entry.c).  Only the time to send a character is
+ * applied when the costs are recomputed.
+ *
+ * Each measurement notes the capability string which it was made for.  A
+ * terminal which does not use that string, e.g., after _nc_mvcur_init
+ * disables save_cursor, measures its own.
+ */
+typedef enum {
+    pfCR = 0
+    ,pfHOME
+    ,pfLL
+    ,pfHT
+    ,pfCBT
+    ,pfCUB1
+    ,pfCUF1
+    ,pfCUD1
+    ,pfCUU1
+    ,pfSMIR
+    ,pfRMIR
+    ,pfIP
+    ,pfCUP
+    ,pfCUB
+    ,pfCUF
+    ,pfCUD
+    ,pfCUU
+    ,pfHPA
+    ,pfVPA
+    ,pfED
+    ,pfEL
+    ,pfEL1
+    ,pfDCH1
+    ,pfICH1
+    ,pfDCH
+    ,pfICH
+    ,pfECH
+    ,pfREP
+    ,pfMAX
+} PROFILE_SLOT;
+
+struct mvcur_profile {
+    struct {
+	const char *cap;	/* the capability which was measured */
+	int chars;		/* characters in its sample */
+	float padding;		/* padding in the sample */
+    } sample[pfMAX];
+};
+
+static struct mvcur_profile *
+cost_profile(NCURSES_SP_DCL0)
+{
+    struct mvcur_profile *profile = 0;
+
+    if (HasTerminal(SP_PARM)) {
+	profile = _nc_shared_profile(&TerminalType(SP_PARM->_term),
+				     sizeof(struct mvcur_profile));
+    }
+    if (profile == 0) {
+	if (SP_PARM->_mvcur_profile == 0)
+	    SP_PARM->_mvcur_profile = typeCalloc(struct mvcur_profile, 1);
+	profile = SP_PARM->_mvcur_profile;
+    }
+    return profile;
+}
+
+/*
+ * Return the cost of a capability, expanded with up to two sample parameters,
+ * reusing the profile's measurement if it has one.
+ */
+static int
+sample_cost(NCURSES_SP_DCLx
+	    struct mvcur_profile *profile,
+	    PROFILE_SLOT slot,
+	    const char *capname,
+	    const char *cap,
+	    int affcnt,
+	    int nparams,
+	    int p1,
+	    int p2)
+{
+    int chars = 0;
+    float padding = 0.0;
+    bool found = FALSE;
+    int result;
+
+    if (cap == 0) {
+	result = INFINITY;
+    } else {
+	if (profile != 0) {
+	    _nc_lock_global(curses);
+	    if (profile->sample[slot].cap == cap) {
+		chars = profile->sample[slot].chars;
+		padding = profile->sample[slot].padding;
+		found = TRUE;
+	    }
+	    _nc_unlock_global(curses);
+	}
+	if (!found) {
+	    const char *sample = cap;
+
+	    if (nparams == 1)
+		sample = TIPARM_1(cap, p1);
+	    else if (nparams == 2)
+		sample = TIPARM_2(cap, p1, p2);
+	    if (sample == 0)
+		return INFINITY;
+	    measure_cap(sample, affcnt, &chars, &padding);
+	    if (profile != 0) {
+		_nc_lock_global(curses);
+		profile->sample[slot].cap = cap;
+		profile->sample[slot].chars = chars;
+		profile->sample[slot].padding = padding;
+		_nc_unlock_global(curses);
+	    }
+	}
+	result = cost_of_measure(NCURSES_SP_ARGx chars, padding);
+    }
+    TR(TRACE_CHARPUT | TRACE_MOVE,
+       ("CostOf %s %d%s", capname, result, found ? " (profile)" : ""));
+    (void) capname;
+    return result;
+}
+
+#define CostOf(slot,cap,affcnt) \
+	sample_cost(NCURSES_SP_ARGx profile, slot, #cap, cap, affcnt, 0, 0, 0)
+#define CostOf1(slot,cap) \
+	sample_cost(NCURSES_SP_ARGx profile, slot, #cap, cap, 1, 1, 23, 0)
+#define CostOf2(slot,cap,p1) \
+	sample_cost(NCURSES_SP_ARGx profile, slot, #cap, cap, 1, 2, p1, 23)
+#define NormalizedCost(cost) normalize_cost(NCURSES_SP_ARGx cost)
+
+/*
+ * Applications which update a few fields repeatedly ask for the same moves
+ * on each refresh.  Remember the strings chosen for recent moves, unless the
+ * choice depended on the text being overwritten.  The table is keyed by both
+ * endpoints, since cursor_address and the home/carriage-return tactics use
+ * absolute positions, and forgotten when the screen size or costs change.
+ */
+#define MEMO_SIZE	64	/* a power of two */
+#define MEMO_TEXT	32	/* longer moves are not remembered */
+
+struct mvcur_memo {
+    int height;
+    int width;
+    struct {
+	short yold, xold;
+	short ynew, xnew;
+	short tactic;
+	bool ovw;
+	bool valid;
+	char text[MEMO_TEXT];
+    } entry[MEMO_SIZE];
+};
+
+#define MemoHash(yold, xold, ynew, xnew) \
+	((unsigned) (((yold) * 7 + (xold)) * 31 + (ynew) * 17 + (xnew)) \
+	 & (MEMO_SIZE - 1))
+
+static void
+forget_moves(NCURSES_SP_DCL0)
+{
+    if (SP_PARM->_mvcur_memo != 0) {
+	int n;
+
+	for (n = 0; n < MEMO_SIZE; ++n)
+	    SP_PARM->_mvcur_memo->entry[n].valid = FALSE;
+    }
+}
+
+static struct mvcur_memo *
+memo_table(NCURSES_SP_DCL0)
+{
+    struct mvcur_memo *memo = SP_PARM->_mvcur_memo;
+
+#if defined(TRACE) || defined(NCURSES_TEST)
+    if (!(_nc_optimize_enable & OPTIMIZE_MVCUR))
+	return 0;
+#endif
+#if defined(MAIN) || defined(NCURSES_TEST)
+    if (profiling)
+	return 0;
+#endif
+    if (memo == 0) {
+	if ((memo = typeCalloc(struct mvcur_memo, 1)) == 0)
+	    return 0;
+	SP_PARM->_mvcur_memo = memo;
+    }
+    if (memo->height != screen_lines(SP_PARM)
+	|| memo->width != screen_columns(SP_PARM)) {
+	forget_moves(NCURSES_SP_ARG);
+	memo->height = screen_lines(SP_PARM);
+	memo->width = screen_columns(SP_PARM);
+    }
+    return memo;
+}
+
 static void
 reset_scroll_region(NCURSES_SP_DCL0)
 /* Set the scroll-region to a known state (the default) */
@@ -326,6 +521,7 @@ NCURSES_SP_NAME(_nc_mvcur_resume) (NCURSES_SP_DCL0)
      */
     reset_scroll_region(NCURSES_SP_ARG);
     SP_PARM->_cursrow = SP_PARM->_curscol = -1;
+    forget_moves(NCURSES_SP_ARG);
 
     /* restore cursor shape */
     if (SP_PARM->_cursor != -1) {
@@ -343,57 +539,80 @@ _nc_mvcur_resume(void)
 }
 #endif
 
-NCURSES_EXPORT(void)
-NCURSES_SP_NAME(_nc_mvcur_init) (NCURSES_SP_DCL0)
-/* initialize the cost structure */
+/*
+ * Return the output rate set by set_output_rate, or that measured by doupdate,
+ * in characters per second.  Zero tells the caller to use the baud rate, which
+ * is meaningless for a pseudo-terminal.
+ */
+static long
+chosen_rate(NCURSES_SP_DCL0)
 {
-    if (SP_PARM->_ofp && NC_ISATTY(fileno(SP_PARM->_ofp))) {
-	SP_PARM->_char_padding = ((BAUDBYTE * 1000 * 10)
-				  / (BAUDRATE(SP_PARM) > 0
-				     ? BAUDRATE(SP_PARM)
-				     : 9600));
-    } else {
-	SP_PARM->_char_padding = 1;	/* must be nonzero */
+    long rate = SP_PARM->_output_rate;
+
+    if (rate <= 0 && SP_PARM->_adaptive_costs)
+	rate = SP_PARM->_measured_rate;
+    return (rate > 0) ? rate : 0;
+}
+
+/*
+ * Return the time to send one character, in 10ths of milliseconds.
+ */
+static int
+padding_of_char(NCURSES_SP_DCL0)
+{
+    long rate = chosen_rate(NCURSES_SP_ARG);
+    int result = 1;
+
+    if (rate > 0) {
+	result = (int) ((1000 * 10) / rate);
+    } else if (SP_PARM->_ofp && NC_ISATTY(fileno(SP_PARM->_ofp))) {
+	result = ((BAUDBYTE * 1000 * 10)
+		  / (BAUDRATE(SP_PARM) > 0
+		     ? BAUDRATE(SP_PARM)
+		     : 9600));
     }
-    if (SP_PARM->_char_padding <= 0)
-	SP_PARM->_char_padding = 1;	/* must be nonzero */
+    if (result <= 0)
+	result = 1;		/* must be nonzero */
+    return result;
+}
+
+static void
+compute_costs(NCURSES_SP_DCL0)
+/* compute the cost of each operation, given the cost of a character */
+{
+    struct mvcur_profile *profile = cost_profile(NCURSES_SP_ARG);
+
     TR(TRACE_CHARPUT | TRACE_MOVE, ("char_padding %d msecs", SP_PARM->_char_padding));
 
+    forget_moves(NCURSES_SP_ARG);
+
     /* non-parameterized local-motion strings */
-    SP_PARM->_cr_cost = CostOf(carriage_return, 0);
-    SP_PARM->_home_cost = CostOf(cursor_home, 0);
-    SP_PARM->_ll_cost = CostOf(cursor_to_ll, 0);
+    SP_PARM->_cr_cost = CostOf(pfCR, carriage_return, 0);
+    SP_PARM->_home_cost = CostOf(pfHOME, cursor_home, 0);
+    SP_PARM->_ll_cost = CostOf(pfLL, cursor_to_ll, 0);
 #if USE_HARD_TABS
     if (getenv("NCURSES_NO_HARD_TABS") == 0
 	&& dest_tabs_magic_smso == 0
 	&& HasHardTabs()) {
-	SP_PARM->_ht_cost = CostOf(tab, 0);
-	SP_PARM->_cbt_cost = CostOf(back_tab, 0);
+	SP_PARM->_ht_cost = CostOf(pfHT, tab, 0);
+	SP_PARM->_cbt_cost = CostOf(pfCBT, back_tab, 0);
     } else {
 	SP_PARM->_ht_cost = INFINITY;
 	SP_PARM->_cbt_cost = INFINITY;
     }
 #endif /* USE_HARD_TABS */
-    SP_PARM->_cub1_cost = CostOf(cursor_left, 0);
-    SP_PARM->_cuf1_cost = CostOf(cursor_right, 0);
-    SP_PARM->_cud1_cost = CostOf(cursor_down, 0);
-    SP_PARM->_cuu1_cost = CostOf(cursor_up, 0);
+    SP_PARM->_cub1_cost = CostOf(pfCUB1, cursor_left, 0);
+    SP_PARM->_cuf1_cost = CostOf(pfCUF1, cursor_right, 0);
+    SP_PARM->_cud1_cost = CostOf(pfCUD1, cursor_down, 0);
+    SP_PARM->_cuu1_cost = CostOf(pfCUU1, cursor_up, 0);
 
-    SP_PARM->_smir_cost = CostOf(enter_insert_mode, 0);
-    SP_PARM->_rmir_cost = CostOf(exit_insert_mode, 0);
+    SP_PARM->_smir_cost = CostOf(pfSMIR, enter_insert_mode, 0);
+    SP_PARM->_rmir_cost = CostOf(pfRMIR, exit_insert_mode, 0);
     SP_PARM->_ip_cost = 0;
     if (insert_padding) {
-	SP_PARM->_ip_cost = CostOf(insert_padding, 0);
+	SP_PARM->_ip_cost = CostOf(pfIP, insert_padding, 0);
     }
 
-    /*
-     * Assumption: if the terminal has memory_relative addressing, the
-     * initialization strings or smcup will set single-page mode so we
-     * can treat it like absolute screen addressing.  This seems to be true
-     * for all cursor_mem_address terminal types in the terminfo database.
-     */
-    SP_PARM->_address_cursor = cursor_address ? cursor_address : cursor_mem_address;
-
     /*
      * Parametrized local-motion strings.  This static cost computation
      * depends on the following assumptions:
@@ -418,20 +637,20 @@ NCURSES_SP_NAME(_nc_mvcur_init) (NCURSES_SP_DCL0)
      * All these averages depend on the assumption that all parameter values
      * are equally probable.
      */
-    SP_PARM->_cup_cost = CostOf(TIPARM_2(SP_PARM->_address_cursor, 23, 23), 1);
-    SP_PARM->_cub_cost = CostOf(TIPARM_1(parm_left_cursor, 23), 1);
-    SP_PARM->_cuf_cost = CostOf(TIPARM_1(parm_right_cursor, 23), 1);
-    SP_PARM->_cud_cost = CostOf(TIPARM_1(parm_down_cursor, 23), 1);
-    SP_PARM->_cuu_cost = CostOf(TIPARM_1(parm_up_cursor, 23), 1);
-    SP_PARM->_hpa_cost = CostOf(TIPARM_1(column_address, 23), 1);
-    SP_PARM->_vpa_cost = CostOf(TIPARM_1(row_address, 23), 1);
+    SP_PARM->_cup_cost = CostOf2(pfCUP, SP_PARM->_address_cursor, 23);
+    SP_PARM->_cub_cost = CostOf1(pfCUB, parm_left_cursor);
+    SP_PARM->_cuf_cost = CostOf1(pfCUF, parm_right_cursor);
+    SP_PARM->_cud_cost = CostOf1(pfCUD, parm_down_cursor);
+    SP_PARM->_cuu_cost = CostOf1(pfCUU, parm_up_cursor);
+    SP_PARM->_hpa_cost = CostOf1(pfHPA, column_address);
+    SP_PARM->_vpa_cost = CostOf1(pfVPA, row_address);
 
     /* non-parameterized screen-update strings */
-    SP_PARM->_ed_cost = NormalizedCost(clr_eos, 1);
-    SP_PARM->_el_cost = NormalizedCost(clr_eol, 1);
-    SP_PARM->_el1_cost = NormalizedCost(clr_bol, 1);
-    SP_PARM->_dch1_cost = NormalizedCost(delete_character, 1);
-    SP_PARM->_ich1_cost = NormalizedCost(insert_character, 1);
+    SP_PARM->_ed_cost = NormalizedCost(CostOf(pfED, clr_eos, 1));
+    SP_PARM->_el_cost = NormalizedCost(CostOf(pfEL, clr_eol, 1));
+    SP_PARM->_el1_cost = NormalizedCost(CostOf(pfEL1, clr_bol, 1));
+    SP_PARM->_dch1_cost = NormalizedCost(CostOf(pfDCH1, delete_character, 1));
+    SP_PARM->_ich1_cost = NormalizedCost(CostOf(pfICH1, insert_character, 1));
 
     /*
      * If this is a bce-terminal, we want to bias the choice so we use clr_eol
@@ -441,19 +660,34 @@ NCURSES_SP_NAME(_nc_mvcur_init) (NCURSES_SP_DCL0)
 	SP_PARM->_el_cost = 0;
 
     /* parameterized screen-update strings */
-    SP_PARM->_dch_cost = NormalizedCost(TIPARM_1(parm_dch, 23), 1);
-    SP_PARM->_ich_cost = NormalizedCost(TIPARM_1(parm_ich, 23), 1);
-    SP_PARM->_ech_cost = NormalizedCost(TIPARM_1(erase_chars, 23), 1);
-    SP_PARM->_rep_cost = NormalizedCost(TIPARM_2(repeat_char, ' ', 23), 1);
-
-    SP_PARM->_cup_ch_cost = NormalizedCost(TIPARM_2(SP_PARM->_address_cursor,
-						    23, 23),
-					   1);
-    SP_PARM->_hpa_ch_cost = NormalizedCost(TIPARM_1(column_address, 23), 1);
-    SP_PARM->_cuf_ch_cost = NormalizedCost(TIPARM_1(parm_right_cursor, 23), 1);
+    SP_PARM->_dch_cost = NormalizedCost(CostOf1(pfDCH, parm_dch));
+    SP_PARM->_ich_cost = NormalizedCost(CostOf1(pfICH, parm_ich));
+    SP_PARM->_ech_cost = NormalizedCost(CostOf1(pfECH, erase_chars));
+    SP_PARM->_rep_cost = NormalizedCost(CostOf2(pfREP, repeat_char, ' '));
+
+    SP_PARM->_cup_ch_cost = NormalizedCost(SP_PARM->_cup_cost);
+    SP_PARM->_hpa_ch_cost = NormalizedCost(SP_PARM->_hpa_cost);
+    SP_PARM->_cuf_ch_cost = NormalizedCost(SP_PARM->_cuf_cost);
     SP_PARM->_inline_cost = Min(SP_PARM->_cup_ch_cost,
 				Min(SP_PARM->_hpa_ch_cost,
 				    SP_PARM->_cuf_ch_cost));
+}
+
+NCURSES_EXPORT(void)
+NCURSES_SP_NAME(_nc_mvcur_init) (NCURSES_SP_DCL0)
+/* initialize the cost structure */
+{
+    SP_PARM->_char_padding = padding_of_char(NCURSES_SP_ARG);
+
+    /*
+     * Assumption: if the terminal has memory_relative addressing, the
+     * initialization strings or smcup will set single-page mode so we
+     * can treat it like absolute screen addressing.  This seems to be true
+     * for all cursor_mem_address terminal types in the terminfo database.
+     */
+    SP_PARM->_address_cursor = cursor_address ? cursor_address : cursor_mem_address;
+
+    compute_costs(NCURSES_SP_ARG);
 
     /*
      * If save_cursor is used within enter_ca_mode, we should not use it for
@@ -485,6 +719,133 @@ _nc_mvcur_init(void)
 }
 #endif
 
+/*
+ * Recompute the costs if the time to send a character has changed.
+ */
+static void
+update_costs(NCURSES_SP_DCL0)
+{
+    int padding = padding_of_char(NCURSES_SP_ARG);
+
+    if (padding != SP_PARM->_char_padding) {
+	SP_PARM->_char_padding = padding;
+	compute_costs(NCURSES_SP_ARG);
+    }
+}
+
+/*
+ * doupdate reports the number of bytes which it wrote for a frame, and how
+ * long that took.  A write which returns at once says only that the kernel
+ * had room for it, so use only those which had to wait for the terminal.
+ */
+#define MIN_RATE_BYTES	512
+#define MIN_RATE_USECS	2000
+
+NCURSES_EXPORT(void)
+_nc_mvcur_rate(SCREEN *sp, long bytes, long usecs)
+{
+    if (sp != 0
+	&& sp->_adaptive_costs
+	&& sp->_output_rate <= 0
+	&& bytes >= MIN_RATE_BYTES
+	&& usecs >= MIN_RATE_USECS) {
+	long sample = (long) (((double) bytes * 1000000.0) / (double) usecs);
+
+	if (sp->_measured_rate > 0)
+	    sp->_measured_rate = (3 * sp->_measured_rate + sample) / 4;
+	else
+	    sp->_measured_rate = sample;
+	TR(TRACE_UPDATE, ("output rate %ld chars/sec (frame %ld bytes, %ld usecs)",
+			  sp->_measured_rate, bytes, usecs));
+#if NCURSES_SP_FUNCS
+	update_costs(sp);
+#else
+	update_costs();
+#endif
+    }
+}
+
+#if NCURSES_EXT_FUNCS
+/*
+ * Let the cost model follow the output rate measured by doupdate, rather
+ * than the baud rate.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(use_adaptive_costs) (NCURSES_SP_DCLx bool flag)
+{
+    int code = ERR;
+
+    T((T_CALLED("use_adaptive_costs(%p,%d)"), (void *) SP_PARM, flag));
+    if (SP_PARM != 0 && HasTerminal(SP_PARM)) {
+	SP_PARM->_adaptive_costs = flag;
+	update_costs(NCURSES_SP_ARG);
+	code = OK;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+use_adaptive_costs(bool flag)
+{
+    return NCURSES_SP_NAME(use_adaptive_costs) (CURRENT_SCREEN, flag);
+}
+#endif
+
+/*
+ * Pin the output rate used by the cost model, in characters per second.
+ * Zero restores the measured or baud rate.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(set_output_rate) (NCURSES_SP_DCLx int rate)
+{
+    int code = ERR;
+
+    T((T_CALLED("set_output_rate(%p,%d)"), (void *) SP_PARM, rate));
+    if (SP_PARM != 0 && HasTerminal(SP_PARM) && rate >= 0) {
+	SP_PARM->_output_rate = rate;
+	update_costs(NCURSES_SP_ARG);
+	code = OK;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+set_output_rate(int rate)
+{
+    return NCURSES_SP_NAME(set_output_rate) (CURRENT_SCREEN, rate);
+}
+#endif
+
+/*
+ * Return the output rate used by the cost model, in characters per second.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(get_output_rate) (NCURSES_SP_DCL0)
+{
+    int code = ERR;
+
+    T((T_CALLED("get_output_rate(%p)"), (void *) SP_PARM));
+    if (SP_PARM != 0 && HasTerminal(SP_PARM)) {
+	long rate = chosen_rate(NCURSES_SP_ARG);
+
+	if (rate <= 0)
+	    rate = BAUDRATE(SP_PARM) / BAUDBYTE;
+	code = (int) rate;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+get_output_rate(void)
+{
+    return NCURSES_SP_NAME(get_output_rate) (CURRENT_SCREEN);
+}
+#endif
+#endif /* NCURSES_EXT_FUNCS */
+
 NCURSES_EXPORT(void)
 NCURSES_SP_NAME(_nc_mvcur_wrap) (NCURSES_SP_DCL0)
 /* wrap up cursor-addressing mode */
@@ -669,6 +1030,8 @@ relative_move(NCURSES_SP_DCLx
 
 		if (n <= 0 || n >= (int) check.s_size)
 		    ovw = FALSE;
+		else if (ovw)
+		    SP_PARM->_mvcur_overwrote = TRUE;
 #if BSD_TPUTS
 		/*
 		 * If we're allowing BSD-style padding in tputs, don't generate
@@ -800,6 +1163,8 @@ onscreen_mvcur(NCURSES_SP_DCLx
     char buffer[OPT_SIZE];
     int tactic = 0, newcost, usecost = INFINITY;
     int t5_cr_cost;
+    struct mvcur_memo *memo = memo_table(NCURSES_SP_ARG);
+    unsigned slot = MemoHash(yold, xold, ynew, xnew);
 
 #if defined(MAIN) || defined(NCURSES_TEST)
     struct timeval before, after;
@@ -807,6 +1172,24 @@ onscreen_mvcur(NCURSES_SP_DCLx
     gettimeofday(&before, NULL);
 #endif /* MAIN */
 
+    if (memo != 0
+	&& memo->entry[slot].valid
+	&& memo->entry[slot].yold == yold
+	&& memo->entry[slot].xold == xold
+	&& memo->entry[slot].ynew == ynew
+	&& memo->entry[slot].xnew == xnew
+	&& memo->entry[slot].ovw == (ovw != 0)) {
+	TR(TRACE_MOVE, ("mvcur tactic %d (remembered)",
+			memo->entry[slot].tactic));
+	TPUTS_TRACE("mvcur");
+	NCURSES_SP_NAME(tputs) (NCURSES_SP_ARGx
+				memo->entry[slot].text, 1, myOutCh);
+	SP_PARM->_cursrow = ynew;
+	SP_PARM->_curscol = xnew;
+	return (OK);
+    }
+    SP_PARM->_mvcur_overwrote = FALSE;
+
 #define NullResult _nc_str_null(&result, sizeof(buffer))
 #define InitResult _nc_str_init(&result, buffer, sizeof(buffer))
 
@@ -958,6 +1341,18 @@ onscreen_mvcur(NCURSES_SP_DCLx
 
     if (usecost != INFINITY) {
 	TR(TRACE_MOVE, ("mvcur tactic %d", tactic));
+	if (memo != 0
+	    && !SP_PARM->_mvcur_overwrote
+	    && strlen(buffer) < MEMO_TEXT) {
+	    memo->entry[slot].yold = (short) yold;
+	    memo->entry[slot].xold = (short) xold;
+	    memo->entry[slot].ynew = (short) ynew;
+	    memo->entry[slot].xnew = (short) xnew;
+	    memo->entry[slot].tactic = (short) tactic;
+	    memo->entry[slot].ovw = (ovw != 0);
+	    memo->entry[slot].valid = TRUE;
+	    strcpy(memo->entry[slot].text, buffer);
+	}
 	TPUTS_TRACE("mvcur");
 	NCURSES_SP_NAME(tputs) (NCURSES_SP_ARGx
 				buffer, 1, myOutCh);
@@ -1078,8 +1473,11 @@ NCURSES_SP_NAME(_nc_mvcur) (NCURSES_SP_DCLx
      * With the terminal-driver, we cannot distinguish between internal and
      * external calls.  Flush the output if the screen has not been
      * initialized, e.g., when used from low-level terminfo programs.
+     * Within doupdate(), the frame is flushed as a whole.
      */
-    if ((SP_PARM != 0) && (SP_PARM->_endwin == ewInitial))
+    if ((SP_PARM != 0)
+	&& (SP_PARM->_endwin == ewInitial)
+	&& !SP_PARM->out_framing)
 	NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
     return rc;
 }
@@ -36,7 +36,7 @@
 /*
 **	lib_twait.c
 **
-**	The routine _nc_timed_wait().
+**	The routines _nc_timed_wait(), _nc_fill_input() and _nc_read_input().
 **
 **	(This file was originally written by Eric Raymond; however except for
 **	comments, none of the original code remains - T.Dickey).
@@ -81,7 +81,7 @@ MODULE_ID("$Id: lib_twait.c,v 1.81 2023/09/16 16:30:40 tom Exp $")
 /*
  * Returns an elapsed time, in milliseconds (if possible).
  */
-static long
+NCURSES_EXPORT(long)
 _nc_gettime(TimeType * t0, int first)
 {
     long res;
@@ -143,10 +143,31 @@ _nc_eventlist_timeout(_nc_eventlist * evl)
 #  define MAYBE_UNUSED GCC_UNUSED
 #endif
 
-#if (USE_FUNC_POLL || HAVE_SELECT)
-#  define MAYBE_UNUSED
+/*
+ * Read the clock only when the elapsed time matters: not when polling, nor
+ * when waiting with no time limit.
+ */
+#if USE_KLIBC_KBD
+#define NeedTime(msecs) ((msecs) >= 0)
 #else
-#  define MAYBE_UNUSED GCC_UNUSED
+#define NeedTime(msecs) ((msecs) > 0)
+#endif
+
+/*
+ * While output left by use_nonblock_output() is queued, also wait for the
+ * output descriptor to become writable, and resume writing it.
+ *
+ * If doupdate skipped a frame because the terminal driver still held earlier
+ * output, there is no descriptor to wait for.  Instead, wake up every
+ * REPLAY_MSECS to see if the frame can be sent.
+ */
+#if USE_FUNC_POLL || (HAVE_SELECT && !defined(__BEOS__) && !USE_KLIBC_KBD)
+#define WAIT_OUTPUT 1
+#define WantOutput(sp) ((sp) != 0 && (sp)->out_pending && (sp)->_ofd >= 0)
+#define WantReplay(sp) ((sp) != 0 && (sp)->_frame_skipped && !(sp)->out_pending)
+#define REPLAY_MSECS 20
+#else
+#define WAIT_OUTPUT 0
 #endif
 
 /*
@@ -158,6 +179,9 @@ _nc_eventlist_timeout(_nc_eventlist * evl)
  *	TW_MOUSE   2 - mouse descriptor, if any
  *	TW_ANY     3 - either input or mouse.
  *      TW_EVENT   4 -
+ * If output is pending, it is resumed whenever the output descriptor becomes
+ * writable, without returning to the caller.
+ *
  * Experimental:  if NCURSES_WGETCH_EVENTS is defined, (mode & 4) determines
  * whether to pay attention to evl argument.  If set, the smallest of
  * millisecond and of timeout of evl is taken.
@@ -185,14 +209,26 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
     int timeout_is_event = 0;
     int n;
 #endif
+#if WAIT_OUTPUT
+    bool resumed;
+    bool forever;
+    bool replay;
+    bool shortened;
+    int remaining = 0;
+#endif
 
 #if USE_FUNC_POLL
 #define MIN_FDS 2
-    struct pollfd fd_list[MIN_FDS];
+#define OUT_FDS 1
+    struct pollfd fd_list[MIN_FDS + OUT_FDS];
+    int out_slot;
     struct pollfd *fds = fd_list;
 #elif defined(__BEOS__)
 #elif HAVE_SELECT
     fd_set set;
+#if WAIT_OUTPUT
+    fd_set out_set;
+#endif
 #endif
 
 #if USE_KLIBC_KBD
@@ -202,6 +238,7 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 #endif
 
     long starttime, returntime;
+    bool timed;
 
 #ifdef NCURSES_WGETCH_EVENTS
     (void) timeout_is_event;
@@ -210,6 +247,20 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
     TR(TRACE_IEVENT, ("start twait: %d milliseconds, mode: %d",
 		      milliseconds, mode));
 
+    /*
+     * Input which was read ahead into the screen's buffer is ready now,
+     * though the descriptor may not be.
+     */
+    if ((mode & TW_INPUT)
+	&& sp != 0
+	&& sp->_inbuf_head < sp->_inbuf_tail) {
+	if (timeleft)
+	    *timeleft = milliseconds;
+	TR(TRACE_IEVENT, ("end twait: %d bytes buffered",
+			  sp->_inbuf_tail - sp->_inbuf_head));
+	return TW_INPUT;
+    }
+
 #ifdef NCURSES_WGETCH_EVENTS
     if (mode & TW_EVENT) {
 	int event_delay = _nc_eventlist_timeout(evl);
@@ -222,10 +273,30 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
     }
 #endif
 
-#if PRECISE_GETTIME && HAVE_NANOSLEEP
+#if WAIT_OUTPUT
+    forever = (milliseconds < 0);
+#endif
+
+#if (PRECISE_GETTIME && HAVE_NANOSLEEP) || WAIT_OUTPUT
   retry:
 #endif
-    starttime = _nc_gettime(&t0, TRUE);
+#if WAIT_OUTPUT
+    replay = (WantReplay(sp) && sp->_resume != 0);
+    shortened = (replay && (forever || milliseconds > REPLAY_MSECS));
+    if (shortened) {
+	remaining = milliseconds;
+	milliseconds = REPLAY_MSECS;
+    }
+#endif
+    timed = NeedTime(milliseconds);
+#ifdef NCURSES_WGETCH_EVENTS
+    if (evl)
+	timed = TRUE;
+#endif
+    starttime = timed ? _nc_gettime(&t0, TRUE) : 0;
+#if WAIT_OUTPUT
+    resumed = FALSE;
+#endif
 
     count = 0;
     (void) count;
@@ -241,7 +312,7 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 #ifdef NCURSES_WGETCH_EVENTS
     if ((mode & TW_EVENT) && evl) {
 	if (fds == fd_list)
-	    fds = typeMalloc(struct pollfd, MIN_FDS + evl->count);
+	    fds = typeMalloc(struct pollfd, MIN_FDS + OUT_FDS + evl->count);
 	if (fds == 0)
 	    return TW_NONE;
     }
@@ -272,9 +343,23 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 	}
     }
 #endif
+    out_slot = -1;
+    if (WantOutput(sp)) {
+	fds[count].fd = sp->_ofd;
+	fds[count].events = POLLOUT;
+	out_slot = count++;
+    }
 
     result = poll(fds, (size_t) count, milliseconds);
 
+    if (result > 0
+	&& out_slot >= 0
+	&& (fds[out_slot].revents & (POLLOUT | POLLERR | POLLHUP))) {
+	--result;
+	resumed = TRUE;
+	fds[out_slot].revents = 0;
+    }
+
 #ifdef NCURSES_WGETCH_EVENTS
     if ((mode & TW_EVENT) && evl) {
 	int c;
@@ -401,13 +486,24 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 	}
     }
 #else
+    FD_ZERO(&out_set);
+    if (WantOutput(sp)) {
+	FD_SET(sp->_ofd, &out_set);
+	count = Max(sp->_ofd + 1, count);
+    }
     if (milliseconds >= 0) {
 	struct timeval ntimeout;
 	ntimeout.tv_sec = milliseconds / 1000;
 	ntimeout.tv_usec = (milliseconds % 1000) * 1000;
-	result = select(count, &set, NULL, NULL, &ntimeout);
+	result = select(count, &set, &out_set, NULL, &ntimeout);
     } else {
-	result = select(count, &set, NULL, NULL, NULL);
+	result = select(count, &set, &out_set, NULL, NULL);
+    }
+    if (result > 0
+	&& WantOutput(sp)
+	&& FD_ISSET(sp->_ofd, &out_set)) {
+	--result;
+	resumed = TRUE;
     }
 #endif
 
@@ -433,11 +529,22 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 
 #endif /* USE_FUNC_POLL, etc */
 
-    returntime = _nc_gettime(&t0, FALSE);
+    returntime = timed ? _nc_gettime(&t0, FALSE) : starttime;
 
     if (milliseconds >= 0)
 	milliseconds -= (int) (returntime - starttime);
 
+#if WAIT_OUTPUT
+    /*
+     * If the wait was shortened to retry a skipped frame, restore the time
+     * remaining.  If there was no activity, try the frame.
+     */
+    if (shortened)
+	milliseconds = forever ? -1 : remaining - (REPLAY_MSECS - milliseconds);
+    if (replay && result == 0)
+	resumed = TRUE;
+#endif
+
 #ifdef NCURSES_WGETCH_EVENTS
     if (evl) {
 	evl->result_flags = 0;
@@ -456,6 +563,27 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
     }
 #endif
 
+#if WAIT_OUTPUT
+    /*
+     * If the only activity was that the output descriptor became writable,
+     * send more of the queued output, and the skipped frame if that is all
+     * sent (see resume_output).  Then continue waiting.
+     */
+    if (resumed) {
+	if (sp->_resume != 0) {
+	    sp->_resume(NCURSES_SP_ARG);
+	} else {
+#if NCURSES_SP_FUNCS
+	    NCURSES_SP_NAME(_nc_flush) (sp);
+#else
+	    _nc_flush();
+#endif
+	}
+	if (result == 0 && (forever || milliseconds > 0))
+	    goto retry;
+    }
+#endif
+
 #if PRECISE_GETTIME && HAVE_NANOSLEEP
     /*
      * If the timeout hasn't expired, and we've gotten no data,
@@ -521,3 +649,46 @@ _nc_timed_wait(SCREEN *sp MAYBE_UNUSED,
 
     return (result);
 }
+
+/*
+ * If the screen's input buffer is empty, refill it with whatever a single
+ * read() returns.  Return the number of bytes buffered, or the result from
+ * read() if that is zero or negative.
+ */
+NCURSES_EXPORT(int)
+_nc_fill_input(SCREEN *sp)
+{
+    int result;
+
+    if (sp->_inbuf_head >= sp->_inbuf_tail) {
+	sp->_inbuf_head = 0;
+	sp->_inbuf_tail = 0;
+	result = (int) read(sp->_ifd, sp->_inbuf, sizeof(sp->_inbuf));
+	TR(TRACE_IEVENT, ("read(%d,buffer,%lu)=%d",
+			  sp->_ifd, (unsigned long) sizeof(sp->_inbuf), result));
+	if (result <= 0)
+	    return result;
+	sp->_inbuf_tail = result;
+    }
+    return sp->_inbuf_tail - sp->_inbuf_head;
+}
+
+/*
+ * Read input for the screen, like read(), but taking it from the screen's
+ * input buffer.  When that is empty, refill it, so that a burst of input such
+ * as pasted text or mouse reports costs one system call rather than one for
+ * each byte.
+ */
+NCURSES_EXPORT(int)
+_nc_read_input(SCREEN *sp, void *buffer, size_t length)
+{
+    int result;
+
+    if ((result = _nc_fill_input(sp)) <= 0)
+	return result;
+    if ((size_t) result > length)
+	result = (int) length;
+    memcpy(buffer, sp->_inbuf + sp->_inbuf_head, (size_t) result);
+    sp->_inbuf_head += result;
+    return result;
+}
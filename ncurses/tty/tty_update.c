@@ -83,6 +83,10 @@
 #endif
 #endif
 
+#if HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>
+#endif
+
 #include <ctype.h>
 
 MODULE_ID("$Id: tty_update.c,v 1.316 2024/02/04 00:09:34 tom Exp $")
@@ -378,7 +382,10 @@ check_pending(NCURSES_SP_DCL0)
     if (SP_PARM->_fifohold != 0)
 	return FALSE;
 
-    if (SP_PARM->_checkfd >= 0) {
+    if (SP_PARM->_checkfd >= 0
+	&& SP_PARM->_inbuf_head < SP_PARM->_inbuf_tail) {
+	have_pending = TRUE;
+    } else if (SP_PARM->_checkfd >= 0) {
 #if USE_FUNC_POLL
 	struct pollfd fds[1];
 	fds[0].fd = SP_PARM->_checkfd;
@@ -732,17 +739,180 @@ PutRange(NCURSES_SP_DCLx
 		win->_line[row].lastchar = _NOCHANGE; \
 		if_USE_SCROLL_HINTS(win->_line[row].oldindex = row)
 
+/*
+ * Synchronized update brackets a frame with markers which tell the terminal
+ * to defer rendering until the whole frame has been received.  If nothing was
+ * written after the opening marker, discard it rather than sending an empty
+ * frame.
+ */
+typedef struct {
+    size_t before;		/* out_inuse before the opening marker */
+    size_t after;		/* out_inuse after the opening marker */
+    size_t chained;		/* out_chained before the opening marker */
+} SYNC_MARK;
+
+static void
+BeginSyncUpdate(NCURSES_SP_DCLx SYNC_MARK * mark)
+{
+    mark->before = SP_PARM->out_inuse;
+    mark->chained = SP_PARM->out_chained;
+    NCURSES_PUTP2("Sync", TIPARM_1(SP_PARM->_sync_update, 1));
+    mark->after = SP_PARM->out_inuse;
+}
+
+static void
+EndSyncUpdate(NCURSES_SP_DCLx const SYNC_MARK * mark)
+{
+    if (SP_PARM->out_chained == mark->chained
+	&& SP_PARM->out_inuse == mark->after
+	&& SP_PARM->out_frame_writes == 0) {
+	TR(TRACE_UPDATE, ("no output, discarding Sync"));
+	SP_PARM->out_inuse = mark->before;
+    } else {
+	NCURSES_PUTP2("Sync", TIPARM_1(SP_PARM->_sync_update, 2));
+    }
+}
+
+/*
+ * Write the frame.  If the cost model follows the output rate, time the write
+ * and report it to lib_mvcur.c.
+ */
+static void
+FlushFrame(NCURSES_SP_DCL0)
+{
+#if PRECISE_GETTIME
+    if (SP_PARM->_adaptive_costs) {
+	TimeType t0, t1;
+	long usecs;
+
+	GetClockTime(&t0);
+	NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
+	GetClockTime(&t1);
+	usecs = (long) ((t1.tv_sec - t0.tv_sec) * 1000000L
+			+ ((long) t1.sub_secs - (long) t0.sub_secs)
+			/ (TimeScale / 1000000L));
+	if (!SP_PARM->out_pending)
+	    _nc_mvcur_rate(SP_PARM, SP_PARM->out_frame_bytes, usecs);
+	return;
+    }
+#endif
+    NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
+}
+
+/*
+ * Check if doupdate has nothing to do:  no rows of newscr or curscr have been
+ * changed, nothing requires repainting the whole screen, and the cursor is
+ * already where newscr puts it.
+ */
+static bool
+nothing_to_update(NCURSES_SP_DCL0)
+{
+    bool result = FALSE;
+
+    if (SP_PARM != 0
+	&& SP_PARM->_damage_top == _NOCHANGE
+	&& SP_PARM->_endwin != ewSuspend
+	&& SP_PARM->_fifohold == 0
+#if USE_SIZECHANGE
+	&& !_nc_globals.have_sigwinch
+	&& !SP_PARM->_sig_winch
+#endif
+#if !USE_REENTRANT
+	&& (SP_PARM != CURRENT_SCREEN
+	    || (CurScreen(SP_PARM) == curscr
+		&& NewScreen(SP_PARM) == newscr
+		&& StdScreen(SP_PARM) == stdscr))
+#endif
+	&& CurScreen(SP_PARM) != 0
+	&& NewScreen(SP_PARM) != 0
+	&& StdScreen(SP_PARM) != 0
+	&& !CurScreen(SP_PARM)->_clear
+	&& !NewScreen(SP_PARM)->_clear) {
+	if (NewScreen(SP_PARM)->_leaveok) {
+	    result = TRUE;
+	} else {
+	    int y = NewScreen(SP_PARM)->_cury;
+	    int x = NewScreen(SP_PARM)->_curx;
+
+	    result = (CurScreen(SP_PARM)->_cury == y
+		      && CurScreen(SP_PARM)->_curx == x
+		      && SP_PARM->_cursrow == y
+		      && SP_PARM->_curscol == x);
+	}
+    }
+    return result;
+}
+
+/*
+ * Check if the output is so far behind that this frame should be skipped,
+ * leaving newscr to be sent by a later doupdate.  Count the output which
+ * ncurses has not sent, as well as that which the terminal driver is still
+ * holding, if the system can tell us.  Output which is merely buffered is
+ * written first, so that it is not mistaken for a backlog.
+ */
+static bool
+output_backlogged(NCURSES_SP_DCL0)
+{
+    long backlog;
+
+    if (SP_PARM->_output_backlog <= 0
+	|| SP_PARM->_endwin == ewSuspend
+#if USE_SIZECHANGE
+	|| _nc_globals.have_sigwinch
+	|| SP_PARM->_sig_winch
+#endif
+	|| SP_PARM->out_buffer == 0)
+	return FALSE;
+
+    if (SP_PARM->out_pending || SP_PARM->out_inuse)
+	NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
+    backlog = (long) _nc_unsent_output(SP_PARM);
+#ifdef TIOCOUTQ
+    if (SP_PARM->_ofd >= 0) {
+	int queued = 0;
+
+	if (ioctl(SP_PARM->_ofd, TIOCOUTQ, &queued) == 0 && queued > 0)
+	    backlog += queued;
+    }
+#endif
+    TR(TRACE_UPDATE, ("output backlog %ld", backlog));
+    return (backlog > SP_PARM->_output_backlog);
+}
+
 NCURSES_EXPORT(int)
 TINFO_DOUPDATE(NCURSES_SP_DCL0)
 {
     int i;
     int nonempty;
+    bool use_sync;
+    SYNC_MARK sync_mark;
 #if USE_TRACE_TIMES
     struct tms before, after;
 #endif /* USE_TRACE_TIMES */
 
     T((T_CALLED("_nc_tinfo:doupdate(%p)"), (void *) SP_PARM));
 
+    if (nothing_to_update(NCURSES_SP_ARG)) {
+	TR(TRACE_UPDATE, ("nothing to update"));
+	/*
+	 * The screen is unchanged, but other output may be buffered, e.g.,
+	 * from init_color or soft-labels.  Restore the attributes as below,
+	 * and send that.
+	 */
+	if (!SameAttrOf(SCREEN_ATTRS(SP_PARM), normal)
+	    || SP_PARM->out_inuse != 0
+	    || SP_PARM->out_pending) {
+	    _nc_lock_global(update);
+#if USE_XMC_SUPPORT
+	    if (magic_cookie_glitch != 0)
+#endif
+		UpdateAttrs(SP_PARM, normal);
+	    NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
+	    _nc_unlock_global(update);
+	}
+	returnCode(OutputStatus(SP_PARM));
+    }
+
     _nc_lock_global(update);
 
     if (SP_PARM == 0) {
@@ -779,6 +949,18 @@ TINFO_DOUPDATE(NCURSES_SP_DCL0)
 	_nc_unlock_global(update);
 	returnCode(ERR);
     }
+
+    /*
+     * If the terminal has not caught up with earlier frames, do not add this
+     * one.  Nothing is changed, so a later frame will send the whole update.
+     */
+    if (output_backlogged(NCURSES_SP_ARG)) {
+	TR(TRACE_UPDATE, ("skipping frame"));
+	SP_PARM->_frame_skipped = TRUE;
+	_nc_unlock_global(update);
+	returnCode(OutputStatus(SP_PARM));
+    }
+    SP_PARM->_frame_skipped = FALSE;
 #ifdef TRACE
     if (USE_TRACEF(TRACE_UPDATE)) {
 	if (CurScreen(SP_PARM)->_clear)
@@ -792,6 +974,17 @@ TINFO_DOUPDATE(NCURSES_SP_DCL0)
 
     _nc_signal_handler(FALSE);
 
+    /*
+     * Collect the output for this frame, so that it can be written at once.
+     */
+    SP_PARM->out_framing = TRUE;
+    SP_PARM->out_frame_bytes = 0;
+    SP_PARM->out_frame_writes = 0;
+
+    use_sync = (SP_PARM->_sync_update != 0 && SP_PARM->out_buffer != 0);
+    if (use_sync)
+	BeginSyncUpdate(NCURSES_SP_ARGx &sync_mark);
+
     if (SP_PARM->_fifohold)
 	SP_PARM->_fifohold--;
 
@@ -1060,6 +1253,7 @@ TINFO_DOUPDATE(NCURSES_SP_DCL0)
 
 	GoTo(NCURSES_SP_ARGx CurScreen(SP_PARM)->_cury, CurScreen(SP_PARM)->_curx);
     }
+    SP_PARM->_damage_top = SP_PARM->_damage_bot = _NOCHANGE;
 
   cleanup:
     /*
@@ -1073,7 +1267,16 @@ TINFO_DOUPDATE(NCURSES_SP_DCL0)
 #endif
 	UpdateAttrs(SP_PARM, normal);
 
-    NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
+    if (use_sync)
+	EndSyncUpdate(NCURSES_SP_ARGx &sync_mark);
+
+    FlushFrame(NCURSES_SP_ARG);
+    SP_PARM->out_framing = FALSE;
+    SP_PARM->out_last_bytes = SP_PARM->out_frame_bytes;
+    SP_PARM->out_last_writes = SP_PARM->out_frame_writes;
+    TR(TRACE_UPDATE, ("Frame output: %ld bytes in %ld writes",
+		      SP_PARM->out_frame_bytes,
+		      SP_PARM->out_frame_writes));
     WINDOW_ATTRS(CurScreen(SP_PARM)) = WINDOW_ATTRS(NewScreen(SP_PARM));
 
 #if USE_TRACE_TIMES
@@ -1088,7 +1291,7 @@ TINFO_DOUPDATE(NCURSES_SP_DCL0)
     _nc_signal_handler(TRUE);
 
     _nc_unlock_global(update);
-    returnCode(OK);
+    returnCode(OutputStatus(SP_PARM));
 }
 
 #if NCURSES_SP_FUNCS && !defined(USE_TERM_DRIVER)
@@ -1099,6 +1302,158 @@ doupdate(void)
 }
 #endif
 
+/*
+ * Write as much of the queued output as the descriptor will accept.  If that
+ * empties the queue and doupdate skipped a frame meanwhile, send it now.
+ * This is resume_output(), and is called from _nc_timed_wait() while waiting
+ * for input.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(_nc_resume_output) (NCURSES_SP_DCL0)
+{
+    if (SP_PARM->out_pending)
+	NCURSES_SP_NAME(_nc_flush) (NCURSES_SP_ARG);
+    if (!SP_PARM->out_pending && SP_PARM->_frame_skipped)
+	return NCURSES_SP_NAME(doupdate) (NCURSES_SP_ARG);
+    return OutputStatus(SP_PARM);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+_nc_resume_output(void)
+{
+    return NCURSES_SP_NAME(_nc_resume_output) (CURRENT_SCREEN);
+}
+#endif
+
+#if NCURSES_EXT_FUNCS
+/*
+ * Returns true if doupdate would have something to do.
+ */
+NCURSES_EXPORT(bool)
+NCURSES_SP_NAME(is_screen_dirty) (NCURSES_SP_DCL0)
+{
+    T((T_CALLED("is_screen_dirty(%p)"), (void *) SP_PARM));
+    returnBool(SP_PARM != 0 && !nothing_to_update(NCURSES_SP_ARG));
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(bool)
+is_screen_dirty(void)
+{
+    return NCURSES_SP_NAME(is_screen_dirty) (CURRENT_SCREEN);
+}
+#endif
+
+/*
+ * Report the range of rows of the screen which may have changed since the
+ * last doupdate.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(get_damage_rows) (NCURSES_SP_DCLx int *top, int *bottom)
+{
+    int code = ERR;
+
+    T((T_CALLED("get_damage_rows(%p,%p,%p)"),
+       (void *) SP_PARM, (void *) top, (void *) bottom));
+
+    if (SP_PARM != 0
+	&& CurScreen(SP_PARM) != 0
+	&& NewScreen(SP_PARM) != 0
+	&& top != 0
+	&& bottom != 0) {
+	if (CurScreen(SP_PARM)->_clear || NewScreen(SP_PARM)->_clear) {
+	    *top = 0;
+	    *bottom = screen_lines(SP_PARM) - 1;
+	    code = OK;
+	} else if (SP_PARM->_damage_top != _NOCHANGE) {
+	    *top = SP_PARM->_damage_top;
+	    *bottom = SP_PARM->_damage_bot;
+	    code = OK;
+	}
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+get_damage_rows(int *top, int *bottom)
+{
+    return NCURSES_SP_NAME(get_damage_rows) (CURRENT_SCREEN, top, bottom);
+}
+#endif
+
+/*
+ * Report the number of bytes and write-calls used for the last frame which
+ * doupdate sent.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(get_frame_stats) (NCURSES_SP_DCLx long *bytes, long *writes)
+{
+    int code = ERR;
+
+    T((T_CALLED("get_frame_stats(%p,%p,%p)"),
+       (void *) SP_PARM, (void *) bytes, (void *) writes));
+
+    if (SP_PARM != 0) {
+	if (bytes != 0)
+	    *bytes = SP_PARM->out_last_bytes;
+	if (writes != 0)
+	    *writes = SP_PARM->out_last_writes;
+	code = OK;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+get_frame_stats(long *bytes, long *writes)
+{
+    return NCURSES_SP_NAME(get_frame_stats) (CURRENT_SCREEN, bytes, writes);
+}
+#endif
+
+/*
+ * Set the number of bytes of unsent output above which doupdate skips
+ * frames.  Zero (the default) disables this.
+ */
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(set_output_backlog) (NCURSES_SP_DCLx int bytes)
+{
+    int code = ERR;
+
+    T((T_CALLED("set_output_backlog(%p,%d)"), (void *) SP_PARM, bytes));
+    if (SP_PARM != 0 && bytes >= 0) {
+	SP_PARM->_output_backlog = bytes;
+	code = OK;
+    }
+    returnCode(code);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+set_output_backlog(int bytes)
+{
+    return NCURSES_SP_NAME(set_output_backlog) (CURRENT_SCREEN, bytes);
+}
+#endif
+
+NCURSES_EXPORT(int)
+NCURSES_SP_NAME(get_output_backlog) (NCURSES_SP_DCL0)
+{
+    T((T_CALLED("get_output_backlog(%p)"), (void *) SP_PARM));
+    returnCode(SP_PARM != 0 ? SP_PARM->_output_backlog : ERR);
+}
+
+#if NCURSES_SP_FUNCS
+NCURSES_EXPORT(int)
+get_output_backlog(void)
+{
+    return NCURSES_SP_NAME(get_output_backlog) (CURRENT_SCREEN);
+}
+#endif
+#endif /* NCURSES_EXT_FUNCS */
+
 /*
  *	ClrBlank(win)
  *
@@ -1326,7 +1681,9 @@ TransformLine(NCURSES_SP_DCLx int const lineno)
 	int oldPair;
 	int newPair;
 
-	for (n = 0; n < screen_columns(SP_PARM); n++) {
+	for (n = _nc_diff_first(newLine, oldLine, screen_columns(SP_PARM));
+	     n < screen_columns(SP_PARM);
+	     n++) {
 	    if (!CharEq(newLine[n], oldLine[n])) {
 		oldPair = GetPair(oldLine[n]);
 		newPair = GetPair(newLine[n]);
@@ -1439,9 +1796,9 @@ TransformLine(NCURSES_SP_DCLx int const lineno)
 	    if (nFirstChar == oFirstChar) {
 		firstChar = nFirstChar;
 		/* find the first differing character */
-		while (firstChar < screen_columns(SP_PARM)
-		       && CharEq(newLine[firstChar], oldLine[firstChar]))
-		    firstChar++;
+		firstChar += _nc_diff_first(newLine + firstChar,
+					    oldLine + firstChar,
+					    screen_columns(SP_PARM) - firstChar);
 	    } else if (oFirstChar > nFirstChar) {
 		firstChar = nFirstChar;
 	    } else {		/* oFirstChar < nFirstChar */
@@ -1464,9 +1821,9 @@ TransformLine(NCURSES_SP_DCLx int const lineno)
 	    }
 	} else {
 	    /* find the first differing character */
-	    while (firstChar < screen_columns(SP_PARM)
-		   && CharEq(newLine[firstChar], oldLine[firstChar]))
-		firstChar++;
+	    firstChar += _nc_diff_first(newLine + firstChar,
+					oldLine + firstChar,
+					screen_columns(SP_PARM) - firstChar);
 	}
 	/* if there wasn't one, we're done */
 	if (firstChar >= screen_columns(SP_PARM)) {
@@ -1478,11 +1835,10 @@ TransformLine(NCURSES_SP_DCLx int const lineno)
 
 	if (!can_clear_with(NCURSES_SP_ARGx CHREF(blank))) {
 	    /* find the last differing character */
-	    nLastChar = screen_columns(SP_PARM) - 1;
-
-	    while (nLastChar > firstChar
-		   && CharEq(newLine[nLastChar], oldLine[nLastChar]))
-		nLastChar--;
+	    nLastChar = firstChar + 1 + _nc_diff_last(newLine + firstChar + 1,
+						      oldLine + firstChar + 1,
+						      screen_columns(SP_PARM)
+						      - firstChar - 1);
 
 	    if (nLastChar >= firstChar) {
 		GoTo(NCURSES_SP_ARGx lineno, firstChar);
@@ -2195,6 +2551,8 @@ NCURSES_SP_NAME(_nc_screen_resume) (NCURSES_SP_DCL0)
 	    NCURSES_PUTP2("exit_am_mode", exit_am_mode);
 	}
     }
+    if (SP_PARM->_paste_on != 0)
+	NCURSES_PUTP2("BE", SP_PARM->_paste_on);
 }
 
 #if NCURSES_SP_FUNCS
@@ -2250,6 +2608,8 @@ NCURSES_SP_NAME(_nc_screen_wrap) (NCURSES_SP_DCL0)
 	if (SP_PARM->_color_defs) {
 	    NCURSES_SP_NAME(_nc_reset_colors) (NCURSES_SP_ARG);
 	}
+	if (SP_PARM->_paste_off != 0)
+	    NCURSES_PUTP2("BD", SP_PARM->_paste_off);
     }
 }
 
@@ -1091,6 +1091,9 @@ main(int argc, char *argv[])
 	}
     }
 
+    if (!(check_only || infodump || capdump))
+	_nc_close_writedir();
+
     /* Show the directory into which entries were written, and the total
      * number of entries
      */
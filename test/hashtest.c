@@ -31,6 +31,9 @@
  *
  * Generate timing statistics for vertical-motion optimization.
  *
+ * With "-f", replay a recorded log file as a log-follower would show it,
+ * e.g., to compare the number of bytes sent with and without "-p".
+ *
  * $Id: hashtest.c,v 1.39 2022/12/04 00:40:11 tom Exp $
  */
 
@@ -46,6 +49,20 @@ static bool extend_corner = FALSE;
 static int foot_lines = 0;
 static int head_lines = 0;
 
+static char **log_text = 0;
+static int log_lines = 0;
+
+static int total_frames = 0;
+static long total_bytes = 0;
+static long total_writes = 0;
+
+static void
+failed(const char *s)
+{
+    perror(s);
+    ExitProgram(EXIT_FAILURE);
+}
+
 static void
 cleanup(void)
 {
@@ -62,6 +79,34 @@ finish(int sig GCC_UNUSED)
     ExitProgram(EXIT_FAILURE);
 }
 
+static void
+show_frame(void)
+{
+    refresh();
+    ++total_frames;
+#if HAVE_GET_FRAME_STATS
+    {
+	long bytes;
+	long writes;
+
+	if (get_frame_stats(&bytes, &writes) == OK) {
+	    total_bytes += bytes;
+	    total_writes += writes;
+	}
+    }
+#endif
+}
+
+static void
+genrule(int row, int width)
+{
+    int j;
+
+    move(row, 0);
+    for (j = 0; j < width; j++)
+	AddCh(UChar((j % 8 == 0) ? ('A' + j / 8) : '-'));
+}
+
 static void
 genlines(int base)
 {
@@ -80,10 +125,8 @@ genlines(int base)
      */
     scrollok(stdscr, FALSE);
 
-    move(0, 0);
     for (i = 0; i < head_lines; i++)
-	for (j = 0; j < COLS; j++)
-	    AddCh(UChar((j % 8 == 0) ? ('A' + j / 8) : '-'));
+	genrule(i, COLS);
 
     move(head_lines, 0);
     for (i = head_lines; i < LINES - foot_lines; i++) {
@@ -94,18 +137,78 @@ genlines(int base)
 	    AddCh(c);
     }
 
-    for (i = LINES - foot_lines; i < LINES; i++) {
-	move(i, 0);
-	for (j = 0; j < (extend_corner ? COLS : COLS - 1); j++)
-	    AddCh(UChar((j % 8 == 0) ? ('A' + j / 8) : '-'));
-    }
+    for (i = LINES - foot_lines; i < LINES; i++)
+	genrule(i, extend_corner ? COLS : COLS - 1);
 
     scrollok(stdscr, TRUE);
     if (single_step) {
 	move(LINES - 1, 0);
 	getch();
     } else
-	refresh();
+	show_frame();
+}
+
+static void
+read_log(const char *filename)
+{
+    FILE *fp;
+    char buffer[BUFSIZ];
+    size_t limit = 0;
+
+    if ((fp = fopen(filename, "r")) == 0)
+	failed(filename);
+    while (fgets(buffer, (int) sizeof(buffer), fp) != 0) {
+	char *s = strchr(buffer, '\n');
+
+	if (s != 0)
+	    *s = '\0';
+	if ((size_t) log_lines >= limit) {
+	    limit = (limit + 1) * 2;
+	    if ((log_text = typeRealloc(char *, limit, log_text)) == 0)
+		failed("read_log");
+	}
+	if ((log_text[log_lines++] = strdup(buffer)) == 0)
+	    failed("read_log");
+    }
+    fclose(fp);
+}
+
+/*
+ * Show the recorded log as "tail -f" would:  each frame adds the next line at
+ * the bottom of the area between header and footer, moving the others up.
+ */
+static void
+follow_log(void)
+{
+    int body = LINES - head_lines - foot_lines;
+    int last;
+
+    for (last = 0; last < log_lines; last++) {
+	int i;
+
+	scrollok(stdscr, FALSE);
+	for (i = 0; i < head_lines; i++)
+	    genrule(i, COLS);
+	for (i = 0; i < body; i++) {
+	    int row = head_lines + i;
+	    int n = last - body + 1 + i;
+	    int width = (extend_corner || (row < LINES - 1)) ? COLS : COLS - 1;
+
+	    move(row, 0);
+	    clrtoeol();
+	    if (n >= 0)
+		addnstr(log_text[n], width);
+	}
+	for (i = LINES - foot_lines; i < LINES; i++)
+	    genrule(i, extend_corner ? COLS : COLS - 1);
+	scrollok(stdscr, TRUE);
+
+	if (single_step) {
+	    move(LINES - 1, 0);
+	    getch();
+	} else
+	    show_frame();
+    }
 }
 
 static void
@@ -141,7 +244,9 @@ run_test(bool optimized GCC_UNUSED)
     }
 #endif
 
-    if (reverse_loops)
+    if (log_text != 0)
+	follow_log();
+    else if (reverse_loops)
 	for (ch = (char) hi; ch >= lo; ch--)
 	    one_cycle(ch);
     else
@@ -160,10 +265,12 @@ usage(int ok)
 	,"Options:"
 	," -c       continuous (don't reset between refresh's)"
 	," -F num   leave 'num' lines constant for footer"
+	," -f file  replay 'file' as a log, adding one line per refresh"
 	," -H num   leave 'num' lines constant for header"
 	," -l num   repeat test 'num' times"
 	," -n       test the normal optimizer"
 	," -o       test the hashed optimizer"
+	," -p       use the patience-diff planner (NCURSES_PATIENCE_SCROLL)"
 	," -r       reverse the loops"
 	," -s       single-step"
 	," -x       assume lower-right corner extension"
@@ -188,7 +295,7 @@ main(int argc, char *argv[])
 
     setlocale(LC_ALL, "");
 
-    while ((ch = getopt(argc, argv, OPTS_COMMON "cF:H:l:norsx")) != -1) {
+    while ((ch = getopt(argc, argv, OPTS_COMMON "cF:f:H:l:noprsx")) != -1) {
 	switch (ch) {
 	case 'c':
 	    continuous = TRUE;
@@ -196,6 +303,9 @@ main(int argc, char *argv[])
 	case 'F':
 	    foot_lines = atoi(optarg);
 	    break;
+	case 'f':
+	    read_log(optarg);
+	    break;
 	case 'H':
 	    head_lines = atoi(optarg);
 	    break;
@@ -209,6 +319,9 @@ main(int argc, char *argv[])
 	case 'o':
 	    test_optimize = TRUE;
 	    break;
+	case 'p':
+	    putenv(strdup("NCURSES_PATIENCE_SCROLL=1"));
+	    break;
 	case 'r':
 	    reverse_loops = TRUE;
 	    break;
@@ -249,6 +362,12 @@ main(int argc, char *argv[])
     }
 
     cleanup();			/* we're done */
+#if HAVE_GET_FRAME_STATS
+    printf("%d frames, %ld bytes, %ld writes\n",
+	   total_frames, total_bytes, total_writes);
+#else
+    printf("%d frames\n", total_frames);
+#endif
     ExitProgram(EXIT_SUCCESS);
 }
 /* hashtest.c ends here */
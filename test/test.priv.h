@@ -115,6 +115,10 @@
 #define HAVE_FILTER 0
 #endif
 
+#ifndef HAVE_GET_FRAME_STATS
+#define HAVE_GET_FRAME_STATS 0
+#endif
+
 #ifndef HAVE_FORM_H
 #define HAVE_FORM_H 0
 #endif
@@ -395,6 +399,10 @@
 #define HAVE__NC_TPARM_ANALYZE 0
 #endif
 
+#ifndef HAVE__NC_TPARM_COMPILE
+#define HAVE__NC_TPARM_COMPILE 0
+#endif
+
 /*
  * Workaround for HPUX
  */
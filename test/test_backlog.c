@@ -0,0 +1,161 @@
+/****************************************************************************
+ * Copyright 2024 agent                                                     *
+ *                                                                          *
+ * Permission is hereby granted, free of charge, to any person obtaining a  *
+ * copy of this software and associated documentation files (the            *
+ * "Software"), to deal in the Software without restriction, including      *
+ * without limitation the rights to use, copy, modify, merge, publish,      *
+ * distribute, distribute with modifications, sublicense, and/or sell       *
+ * copies of the Software, and to permit persons to whom the Software is    *
+ * furnished to do so, subject to the following conditions:                 *
+ *                                                                          *
+ * The above copyright notice and this permission notice shall be included  *
+ * in all copies or substantial portions of the Software.                   *
+ *                                                                          *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS  *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF               *
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.   *
+ * IN NO EVENT SHALL THE ABOVE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,   *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR    *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR    *
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.                               *
+ *                                                                          *
+ * Except as contained in this notice, the name(s) of the above copyright   *
+ * holders shall not be used in advertising or otherwise to promote the     *
+ * sale, use or other dealings in this Software without prior written       *
+ * authorization.                                                           *
+ ****************************************************************************/
+/*
+ * $Id$
+ *
+ * Repaint the screen faster than the terminal accepts it, with
+ * set_output_backlog(), so that doupdate skips frames.  Then check that the
+ * last frame is sent while getch waits for input.
+ */
+#include <test.priv.h>
+
+#if defined(NCURSES_VERSION) && defined(OUTPUT_PENDING)
+
+#include <fcntl.h>
+
+static void
+usage(int ok)
+{
+    static const char *msg[] =
+    {
+	"Usage: test_backlog [options]"
+	,""
+	,"Options:"
+	," -b num   skip frames when more than 'num' bytes are unsent (default 1)"
+	," -f num   repaint the screen 'num' times (default 1000)"
+	," -n       use non-blocking output (use_nonblock_output)"
+	," -t num   wait 'num' milliseconds in getch (default 2000)"
+	,""
+	,USAGE_COMMON
+    };
+    size_t n;
+
+    for (n = 0; n < SIZEOF(msg); n++)
+	fprintf(stderr, "%s\n", msg[n]);
+
+    ExitProgram(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+/* *INDENT-OFF* */
+VERSION_COMMON()
+/* *INDENT-ON* */
+
+static void
+paint(int frame)
+{
+    int y, x;
+
+    for (y = 0; y < LINES; y++) {
+	move(y, 0);
+	for (x = 0; x < COLS - 1; x++)
+	    addch((chtype) ('a' + ((frame + x + y) % 26)));
+    }
+    mvprintw(0, 0, "frame %d", frame);
+}
+
+int
+main(int argc, char *argv[])
+{
+    int ch;
+    int n;
+    int opt_b = 1;
+    int opt_f = 1000;
+    bool opt_n = FALSE;
+    int opt_t = 2000;
+    int flags = 0;
+    int skipped = 0;
+    bool last_skipped;
+    bool last_sent;
+
+    while ((ch = getopt(argc, argv, "b:f:nt:" OPTS_COMMON)) != -1) {
+	switch (ch) {
+	case 'b':
+	    opt_b = atoi(optarg);
+	    break;
+	case 'f':
+	    opt_f = atoi(optarg);
+	    break;
+	case 'n':
+	    opt_n = TRUE;
+	    break;
+	case 't':
+	    opt_t = atoi(optarg);
+	    break;
+	case OPTS_VERSION:
+	    show_version(argv);
+	    ExitProgram(EXIT_SUCCESS);
+	default:
+	    usage(ch == OPTS_USAGE);
+	    /* NOTREACHED */
+	}
+    }
+    if (optind < argc)
+	usage(FALSE);
+
+    initscr();
+    cbreak();
+    noecho();
+    if (opt_n) {
+	flags = fcntl(fileno(stdout), F_GETFL);
+	fcntl(fileno(stdout), F_SETFL, flags | O_NONBLOCK);
+	use_nonblock_output(TRUE);
+    }
+    set_output_backlog(opt_b);
+
+    for (n = 0; n < opt_f; n++) {
+	paint(n);
+	refresh();
+	if (is_screen_dirty())
+	    ++skipped;
+    }
+    last_skipped = is_screen_dirty();
+
+    timeout(opt_t);
+    getch();
+    last_sent = !is_screen_dirty();
+
+    endwin();
+    if (opt_n)
+	fcntl(fileno(stdout), F_SETFL, flags);
+
+    printf("%d frames, %d skipped, last frame %s\n",
+	   opt_f, skipped,
+	   (last_skipped
+	    ? (last_sent
+	       ? "skipped, then sent by getch"
+	       : "skipped, and NOT sent by getch")
+	    : "sent"));
+    ExitProgram((last_skipped && !last_sent) ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+#else
+int
+main(void)
+{
+    printf("This program requires the ncurses set_output_backlog function\n");
+    ExitProgram(EXIT_FAILURE);
+}
+#endif
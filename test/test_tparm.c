@@ -80,11 +80,16 @@ static int i_opt;
 static int s_opt;
 #endif
 
+#if HAVE__NC_TPARM_COMPILE
+static int c_opt;
+#endif
+
 /*
  * Total tests (and failures):
  */
 static long total_tests;
 static long total_fails;
+static long total_diffs;
 
 /*
  * Total characters formatted for tputs:
@@ -244,15 +249,17 @@ analyze_format(const char *format, int *mask, char **p_is_s)
 #define NS_8(fmt)	NS_7(fmt), NumStr(7)
 #define NS_9(fmt)	NS_8(fmt), NumStr(8)
 
-static void
-test_tparm(const char *name, const char *format, long *number, char **string)
+static char *
+format_tparm(const char *format,
+	     int nparam,
+	     int mask,
+	     char **use_strings,
+	     long *number,
+	     char **string)
 {
-    char *use_strings[MAX_PARM];
     char *result = NULL;
-    int nparam;
-    int mask;
 
-    nparam = analyze_format(format, &mask, use_strings);
+    (void) mask;
 #if HAVE_TIPARM_S
     if (s_opt) {
 	switch (nparam) {
@@ -326,6 +333,97 @@ test_tparm(const char *name, const char *format, long *number, char **string)
     } else
 #endif
 	result = tparm(NS_9(format));
+    return result;
+}
+
+#if HAVE__NC_TPARM_COMPILE
+extern int _nc_tparm_compile(int);
+extern void _nc_reset_tparm(TERMINAL *);
+
+static void
+show_result(const char *result)
+{
+    if (result == NULL) {
+	printf("<null>");
+    } else {
+	while (*result != '\0') {
+	    int ch = UChar(*result++);
+	    if (ch < 32 || ch >= 127)
+		printf("\\%03o", ch);
+	    else
+		putchar(ch);
+	}
+    }
+}
+
+/*
+ * Check that the compiled form of the capability gives the same result as the
+ * reference interpreter.  Reset the static variables before each, since some
+ * capabilities use those.
+ */
+static char *
+compare_tparm(const char *name,
+	      const char *format,
+	      int nparam,
+	      int mask,
+	      char **use_strings,
+	      long *number,
+	      char **string)
+{
+    char *result;
+    char *compiled;
+    char *reference;
+
+    _nc_reset_tparm(cur_term);
+    result = format_tparm(format, nparam, mask, use_strings, number, string);
+    compiled = (result != NULL) ? strdup(result) : NULL;
+
+    _nc_reset_tparm(cur_term);
+    _nc_tparm_compile(FALSE);
+    reference = format_tparm(format, nparam, mask, use_strings, number, string);
+    _nc_tparm_compile(TRUE);
+
+    if ((compiled == NULL) != (reference == NULL)
+	|| (compiled != NULL && strcmp(compiled, reference))) {
+	int n;
+
+	total_diffs++;
+	printf("** %s differs:", name);
+	for (n = 0; n < nparam; ++n) {
+	    if (use_strings[n]) {
+		printf(" \"%s\"", number[n] ? string[n] : "?");
+	    } else {
+		printf(" %ld", number[n]);
+	    }
+	}
+	printf("\n\tcompiled  ");
+	show_result(compiled);
+	printf("\n\treference ");
+	show_result(reference);
+	printf("\n");
+    }
+    free(compiled);
+    return reference;
+}
+#endif
+
+static void
+test_tparm(const char *name, const char *format, long *number, char **string)
+{
+    char *use_strings[MAX_PARM];
+    char *result = NULL;
+    int nparam;
+    int mask;
+
+    nparam = analyze_format(format, &mask, use_strings);
+#if HAVE__NC_TPARM_COMPILE
+    if (c_opt)
+	result = compare_tparm(name, format, nparam, mask,
+			       use_strings, number, string);
+    else
+#endif
+	result = format_tparm(format, nparam, mask,
+			      use_strings, number, string);
     total_tests++;
     if (result != NULL) {
 	tputs(result, 1, output_func);
@@ -365,6 +463,9 @@ usage(int ok)
 	,"          to read a list from standard-input"
 	," -a       test all combinations of parameters"
 	,"          [value1...] forms a vector of maximum parameter-values."
+#if HAVE__NC_TPARM_COMPILE
+	," -c       compare compiled capabilities with the reference interpreter"
+#endif
 #if HAVE_TIPARM
 	," -i       test tiparm rather than tparm"
 #endif
@@ -426,7 +527,7 @@ main(int argc, char *argv[])
     if (all_caps == 0 || all_terms == 0 || num_parms == 0 || str_parms == 0)
 	failed("no memory");
 
-    while ((ch = getopt(argc, argv, OPTS_COMMON "T:aipr:sv")) != -1) {
+    while ((ch = getopt(argc, argv, OPTS_COMMON "T:acipr:sv")) != -1) {
 	switch (ch) {
 	case 'T':
 	    t_opt = optarg;
@@ -434,6 +535,11 @@ main(int argc, char *argv[])
 	case 'a':
 	    ++a_opt;
 	    break;
+#if HAVE__NC_TPARM_COMPILE
+	case 'c':
+	    ++c_opt;
+	    break;
+#endif
 #if HAVE_TIPARM
 	case 'i':
 	    ++i_opt;
@@ -676,6 +782,8 @@ main(int argc, char *argv[])
     printf(NUMFORM " total\n", total_tests);
     if (total_fails)
 	printf(NUMFORM " failed\n", total_fails);
+    if (total_diffs)
+	printf(NUMFORM " differed\n", total_diffs);
     printf("Characters:\n");
     printf(NUMFORM " nulls\n", total_nulls);
     printf(NUMFORM " controls\n", total_ctrls);